@@ -0,0 +1,173 @@
+// Counts heap allocations per steady-state editor frame: an ImGui frame with the
+// editor's option widgets plus a control-point drag through the spatial index and
+// the incremental curve update, in every tessellation mode with either tangent mode
+// (natural spline drags patch their tangents, and now and then solve the whole curve
+// again). Global operator new, plain and aligned (the control-point arrays), and
+// ImGui's allocator are hooked. Exits with status 1 if any steady-state frame
+// allocated; registered with ctest.
+//
+// Usage: bench_allocations [control points] [frames]
+
+#include "curve.h"
+#include "imgui.h"
+#include "pointgrid.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    allocationCount++;
+    return malloc(size ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// The aligned forms, which CurveDocument's AlignedAllocator uses for the control points.
+// aligned_alloc wants a size that is a multiple of the alignment.
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    allocationCount++;
+    size_t a = (size_t)alignment;
+    return aligned_alloc(a, (size + a - 1) / a * a + (size ? 0 : a));
+}
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (void *p = operator new(size, alignment, std::nothrow))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+void operator delete(void *p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { free(p); }
+
+static void *imguiAlloc(size_t size, void *)
+{
+    allocationCount++;
+    return malloc(size);
+}
+static void imguiFree(void *p, void *) { free(p); }
+
+static const int width = 640, height = 640;
+static PointGrid controlPointGrid;
+
+static void moveControlPoint(int i, float x, float y)
+{
+    curveDocumentMove(curveDocument, i, x, y);
+    pointGridMove(controlPointGrid, i, x, y);
+    markControlPointDirty(i);
+}
+
+// One editor frame: the option widgets, a pick, and a drag step of point `dragged`
+static void frame(int dragged, int step)
+{
+    ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+    ImGui::NewFrame();
+    ImGui::Begin("Options");
+    ImGui::Checkbox("Show Tangents", &showTangents);
+    const char *modes[] = {tessellationModeName(TESSELLATE_DIRECT), tessellationModeName(TESSELLATE_FORWARD_DIFFERENCE),
+                           tessellationModeName(TESSELLATE_ADAPTIVE)};
+    ImGui::Combo("Tessellation", &tessellationMode, modes, IM_ARRAYSIZE(modes));
+    ImGui::SliderFloat("Tolerance (px)", &curveTolerance, 0.1f, 10.0f, "%.2f");
+    ImGui::Text("Curve vertices: %d", (int)(piecewiseBezier.size() / 2));
+    ImGui::End();
+    ImGui::Begin("Toolbox", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Text("Current mode: %s", "'Select'");
+    ImGui::Button("Clear");
+    ImGui::End();
+    ImGui::Render();
+
+    float angle = 0.1f * step;
+    float x = curveDocument.x[dragged] + 3.0f * std::cos(angle);
+    float y = curveDocument.y[dragged] + 3.0f * std::sin(angle);
+    pointGridNearest(controlPointGrid, curveDocument.x.data(), curveDocument.y.data(), x, y, 3.0f);
+    moveControlPoint(dragged, x, y);
+
+    vertexRange points, polyline, curve, tangents;
+    updateCurve(points, polyline, curve, tangents);
+}
+
+int main(int argc, char *argv[])
+{
+    int npts = argc > 1 ? atoi(argv[1]) : 10000;
+    int frames = argc > 2 ? atoi(argv[2]) : 1000;
+    if (npts < 2 || frames < 1)
+    {
+        fprintf(stderr, "usage: %s [control points >= 2] [frames >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree);
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float)width, (float)height);
+    io.IniFilename = nullptr;
+    unsigned char *pixels;
+    int texWidth, texHeight;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &texWidth, &texHeight);
+
+    // A random walk of clicks inside the window
+    srand(1);
+    pointGridInit(controlPointGrid, 3.0f, width, height);
+    curveDocumentSetWindow(curveDocument, width, height);
+    float x = width / 2.0f, y = height / 2.0f;
+    for (int i = 0; i < npts; i++)
+    {
+        x = std::fmin(std::fmax(x + (rand() / (float)RAND_MAX - 0.5f) * 40.0f, 0.0f), (float)width);
+        y = std::fmin(std::fmax(y + (rand() / (float)RAND_MAX - 0.5f) * 40.0f, 0.0f), (float)height);
+        curveDocumentAdd(curveDocument, x, y);
+        pointGridInsert(controlPointGrid, i, x, y);
+        markControlPointDirty(i);
+    }
+
+    bool failed = false;
+    for (int tangents = TANGENTS_CENTRAL_DIFFERENCE; tangents <= TANGENTS_NATURAL_SPLINE; tangents++)
+    {
+        for (int mode = TESSELLATE_DIRECT; mode <= TESSELLATE_ADAPTIVE; mode++)
+        {
+            tangentMode = tangents;
+            tessellationMode = mode;
+            int dragged = npts / 2;
+            for (int f = 0; f < 100; f++) // Warm up: full rebuild, ImGui windows, buffer capacities
+                frame(dragged, f);
+
+            size_t before = allocationCount, worst = 0;
+            for (int f = 0; f < frames; f++)
+            {
+                size_t start = allocationCount;
+                frame(dragged, 100 + f);
+                worst = std::max(worst, allocationCount - start);
+            }
+            size_t total = allocationCount - before;
+            printf("%-22s %-26s %d points, %d frames: %zu allocations (worst frame %zu)\n",
+                   tessellationModeName((TessellationMode)mode), tangentModeName((TangentMode)tangents), npts, frames,
+                   total, worst);
+            failed |= total > 0;
+        }
+    }
+
+    ImGui::DestroyContext();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,834 @@
+// Benchmark suite for the editor's hot paths across curve sizes: control polyline,
+// piecewise Bezier tessellation (every backend), tangent visuals, the natural spline
+// tangent solvers (Thomas and partitioned), the incremental drag update (with either
+// tangents), control-point picking, vertex packing and, when a headless GL context is
+// available, the VBO upload path in every vertex format and drawing the
+// curve from CPU-tessellated vertices versus evaluating it in bezier.vs, in the
+// tessellation shaders or in the compute pass. Also reports the error of each compact
+// vertex format, and of every GPU path, against the CPU curve, and of patched natural
+// spline drags against a full solve.
+//
+// Each case is warmed up, then timed over a number of repetitions; a repetition
+// batches enough calls to take at least ~50 us so small sizes stay above the clock
+// resolution. Reports min/median/p99/mean time per call.
+//
+// Usage: bench_curve [--sizes 10,100,...] [--max-points N] [--repetitions N]
+//                    [--filter substring] [--json file]
+
+#include "curve.h"
+#include "pointgrid.h"
+#include "threadpool.h"
+#include "vertexformat.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if HAVE_HEADLESS_GL
+#include "computetessellator.h"
+#include "gpubuffer.h"
+#include "headlessgl.h"
+#endif
+
+struct BenchResult
+{
+    std::string name;
+    int points;
+    int repetitions;
+    double minNs, medianNs, p99Ns, meanNs;
+};
+
+static std::vector<BenchResult> results;
+static int repetitions = 30;
+static const char *filter = nullptr;
+static bool haveGL = false;
+
+#if HAVE_HEADLESS_GL
+static GLuint curveProgram = 0, bezierProgram = 0, tessellationProgram = 0, computeProgram = 0;
+static GLint curveDequantizeLocation = -1, bezierSamplesLocation = -1;
+static GLint pixelScaleLocation = -1, toleranceLocation = -1;
+static GLuint targetFramebuffer = 0, targetColor = 0;
+
+static GLuint compileShader(const char *filename, GLenum type)
+{
+    std::string path = std::string(CURVE_SHADER_DIR "/") + filename, source;
+    FILE *in = fopen(path.c_str(), "rb");
+    if (in == NULL)
+    {
+        perror(path.c_str());
+        return 0;
+    }
+    char chunk[4096];
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), in)) > 0;)
+        source.append(chunk, n);
+    fclose(in);
+
+    GLuint shader = glCreateShader(type);
+    const char *text = source.c_str();
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "%s: %s\n", path.c_str(), log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// One of the editor's programs, with gl_Position (and the tessellation shaders' segmentT)
+// also captured by transform feedback
+static GLuint createBenchProgram(const char *vertexShader, const char *controlShader = nullptr,
+                                 const char *evaluationShader = nullptr)
+{
+    GLuint shaders[4] = {compileShader(vertexShader, GL_VERTEX_SHADER), compileShader("fshader.fs", GL_FRAGMENT_SHADER),
+                         controlShader ? compileShader(controlShader, GL_TESS_CONTROL_SHADER) : 0,
+                         evaluationShader ? compileShader(evaluationShader, GL_TESS_EVALUATION_SHADER) : 0};
+    int count = evaluationShader ? 4 : 2;
+    GLuint program = glCreateProgram();
+    for (int i = 0; i < count; i++)
+    {
+        if (shaders[i] == 0)
+        {
+            glDeleteProgram(program);
+            return 0;
+        }
+        glAttachShader(program, shaders[i]);
+        glDeleteShader(shaders[i]);
+    }
+    const char *varyings[] = {"gl_Position", "segmentT"};
+    glTransformFeedbackVaryings(program, evaluationShader ? 2 : 1, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        fprintf(stderr, "%s: link error\n", vertexShader);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static GLuint createComputeBenchProgram(const char *computeShader)
+{
+    GLuint shader = compileShader(computeShader, GL_COMPUTE_SHADER);
+    if (shader == 0)
+        return 0;
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        fprintf(stderr, "%s: link error\n", computeShader);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// Programs and an offscreen 640x640 target like the editor window; false if unusable
+static bool initGLResources()
+{
+    curveProgram = createBenchProgram("vshader.vs");
+    bezierProgram = createBenchProgram("bezier.vs");
+    if (curveProgram == 0 || bezierProgram == 0)
+        return false;
+    curveDequantizeLocation = glGetUniformLocation(curveProgram, "dequantize");
+    bezierSamplesLocation = glGetUniformLocation(bezierProgram, "samples");
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major >= 4)
+        tessellationProgram = createBenchProgram("bezierpatch.vs", "bezier.tcs", "bezier.tes");
+    if (major * 10 + minor >= 43)
+        computeProgram = createComputeBenchProgram("bezier.comp");
+    if (!computeProgram)
+        printf("GL: no OpenGL 4.3 compute shaders, skipping the compute shader path\n");
+    if (tessellationProgram)
+    {
+        pixelScaleLocation = glGetUniformLocation(tessellationProgram, "pixelScale");
+        toleranceLocation = glGetUniformLocation(tessellationProgram, "tolerance");
+    }
+    else
+        printf("GL: no OpenGL 4.0 tessellation shaders, skipping the tessellation shader path\n");
+
+    glGenRenderbuffers(1, &targetColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, targetColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 640, 640);
+    glGenFramebuffers(1, &targetFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, targetColor);
+    glViewport(0, 0, 640, 640);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void destroyGLResources()
+{
+    glDeleteProgram(curveProgram);
+    glDeleteProgram(bezierProgram);
+    glDeleteProgram(tessellationProgram);
+    glDeleteProgram(computeProgram);
+    glDeleteFramebuffers(1, &targetFramebuffer);
+    glDeleteRenderbuffers(1, &targetColor);
+}
+#endif
+
+static double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Time run() per call. setup() runs before every batch, outside the timed region.
+static void bench(const char *name, int points, const std::function<void()> &run,
+                  const std::function<void()> &setup = nullptr)
+{
+    if (filter && !strstr(name, filter))
+        return;
+
+    // Warm up, and size the batch so that one repetition takes at least ~50 us
+    int batch = 1;
+    for (;;)
+    {
+        if (setup)
+            setup();
+        double start = nowNs();
+        for (int b = 0; b < batch; b++)
+            run();
+        if (nowNs() - start >= 50e3 || batch >= (1 << 20))
+            break;
+        batch *= 2;
+    }
+
+    std::vector<double> samples(repetitions);
+    for (int r = 0; r < repetitions; r++)
+    {
+        if (setup)
+            setup();
+        double start = nowNs();
+        for (int b = 0; b < batch; b++)
+            run();
+        samples[r] = (nowNs() - start) / batch;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.points = points;
+    result.repetitions = repetitions;
+    result.minNs = samples.front();
+    result.medianNs = samples[samples.size() / 2];
+    result.p99Ns = samples[std::min(samples.size() - 1, (size_t)std::ceil(0.99 * samples.size()) - 1)];
+    double sum = 0.0;
+    for (double s : samples)
+        sum += s;
+    result.meanNs = sum / samples.size();
+    results.push_back(result);
+
+    printf("%-34s %10d %14.0f %14.0f %14.0f %14.0f\n", name, points, result.minNs, result.medianNs,
+           result.p99Ns, result.meanNs);
+    fflush(stdout);
+}
+
+// Median of a finished benchmark, or 0 if the filter skipped it
+static double medianNs(const char *name, int points)
+{
+    for (const BenchResult &r : results)
+        if (r.name == name && r.points == points)
+            return r.medianNs;
+    return 0.0;
+}
+
+// A random walk of clicks ~20 px apart in a 640x640 window
+static void makeCurve(int npts)
+{
+    srand(1);
+    curveDocumentClear(curveDocument);
+    curveDocumentSetWindow(curveDocument, 640.0f, 640.0f);
+    float x = 320.0f, y = 320.0f;
+    for (int i = 0; i < npts; i++)
+    {
+        x = std::fmin(std::fmax(x + (rand() / (float)RAND_MAX - 0.5f) * 40.0f, 0.0f), 640.0f);
+        y = std::fmin(std::fmax(y + (rand() / (float)RAND_MAX - 0.5f) * 40.0f, 0.0f), 640.0f);
+        curveDocumentAdd(curveDocument, x, y);
+    }
+}
+
+#if HAVE_HEADLESS_GL
+// Capture the tessellation shaders' line vertices at tolerance, with the (segment, t)
+// they came from, and check them against sampleCubicForwardDifference() at the pieces
+// bezier.tcs should pick: the CPU's adaptive count, rounded up to a whole number of
+// isolines of at most maxLevel pieces
+static void checkTessellationShaders(GLuint patchArray, const DynamicBuffer &nodes, int npts, int maxLevel, float tolerance)
+{
+    const float pixelScale = 320.0f;
+    glUniform1f(toleranceLocation, tolerance);
+    int segments = npts - 1;
+    std::vector<int> pieces(segments), firstSample(segments + 1, 0);
+    std::vector<point2d> ctrl(4 * (size_t)segments);
+    size_t cpuVertices = 0;
+    int split = 0; // Segments over several isolines
+    for (int i = 0; i < segments; i++)
+    {
+        const float *b = &bezierNodeVertices[4 * i];
+        point2d *c = &ctrl[4 * i];
+        c[0] = {b[0], b[1]};
+        c[1] = {b[0] + b[2] / 3.0f, b[1] + b[3] / 3.0f};
+        c[2] = {b[4] - b[6] / 3.0f, b[5] - b[7] / 3.0f};
+        c[3] = {b[4], b[5]};
+        int cpuPieces = adaptiveSampleCount(c, pixelScale, pixelScale, tolerance, 1025) - 1;
+        int lines = (cpuPieces + maxLevel - 1) / maxLevel;
+        pieces[i] = lines * ((cpuPieces + lines - 1) / lines);
+        cpuVertices += 2 * (size_t)cpuPieces;
+        split += lines > 1;
+        firstSample[i + 1] = firstSample[i] + pieces[i] + 1;
+    }
+    size_t lineVertices = 2 * (size_t)(firstSample[segments] - segments);
+    if (lineVertices > (1u << 24))
+        return;
+    std::vector<float> reference(2 * (size_t)firstSample[segments]);
+    for (int i = 0; i < segments; i++)
+        sampleCubicForwardDifference(&ctrl[4 * i], pieces[i] + 1, 0, &reference[2 * firstSample[i]]);
+
+    // Room for twice the expected output, so that levels differing from the CPU's still get captured
+    const size_t stride = 6; // gl_Position, segmentT
+    size_t capacity = 2 * lineVertices;
+    GLuint feedback, written;
+    glGenBuffers(1, &feedback);
+    glGenQueries(1, &written);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, capacity * stride * sizeof(float), nullptr, GL_STREAM_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, written);
+    glBeginTransformFeedback(GL_LINES);
+    drawBezierPatches(patchArray, nodes);
+    glEndTransformFeedback();
+    glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+    glDisable(GL_RASTERIZER_DISCARD);
+    GLuint lines = 0;
+    glGetQueryObjectuiv(written, GL_QUERY_RESULT, &lines);
+
+    const float *gpu = (const float *)glMapBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, capacity * stride * sizeof(float), GL_MAP_READ_BIT);
+    std::vector<int> captured(segments, 0);
+    double maxError = 0.0;
+    for (size_t v = 0; gpu && v < 2 * (size_t)lines; v++)
+    {
+        const float *vertex = gpu + stride * v;
+        int i = (int)vertex[4];
+        if (i < 0 || i >= segments)
+            continue;
+        captured[i]++;
+        int k = (int)std::lround(vertex[5] * pieces[i]);
+        const float *expected = &reference[2 * (firstSample[i] + k)];
+        for (int axis = 0; axis < 2; axis++)
+            maxError = std::max(maxError, std::fabs((double)vertex[axis] - expected[axis]));
+    }
+    glUnmapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER);
+    int levelMismatches = 0;
+    for (int i = 0; i < segments; i++)
+        levelMismatches += captured[i] != 2 * pieces[i];
+    printf("  gpu tessellation %d segments at %g px: %zu line vertices (CPU adaptive: %zu), %d split, "
+           "%d segments at another level, max error %.3g px\n",
+           segments, tolerance, 2 * (size_t)lines, cpuVertices, split, levelMismatches, gpu ? pixelScale * maxError : -1.0);
+
+    glDeleteQueries(1, &written);
+    glDeleteBuffers(1, &feedback);
+}
+
+// The tessellation shader path on the nodes of the current curve, for the editor's
+// 640x640 window. bezier.tcs picks the pieces per segment with the CPU's adaptive bound,
+// which checkTessellationShaders() holds it to.
+static void benchTessellationShaders(const DynamicBuffer &nodes, int npts)
+{
+    const float pixelScale = 320.0f;
+    GLint maxLevel = 64;
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &maxLevel);
+    GLuint patchArray = createBezierPatchArray(nodes);
+    glUseProgram(tessellationProgram);
+    glUniform2f(pixelScaleLocation, pixelScale, pixelScale);
+    glUniform1f(toleranceLocation, curveTolerance);
+    if (npts <= 100000)
+        bench("draw/gpu-tessellated", npts, [&]
+              {
+                  drawBezierPatches(patchArray, nodes);
+                  glFinish();
+              });
+
+    // At the editor's tolerance, then on short curves at one fine enough that segments
+    // need more pieces than one isoline can have and bezier.tcs splits them. (llvmpipe
+    // captures some segments more than once when one draw emits over a million or so
+    // vertices at such levels.)
+    if (!filter || strstr("gpu tessellation error", filter))
+    {
+        checkTessellationShaders(patchArray, nodes, npts, maxLevel, curveTolerance);
+        if (npts <= 1000)
+            checkTessellationShaders(patchArray, nodes, npts, maxLevel, 0.002f);
+        glUniform1f(toleranceLocation, curveTolerance);
+    }
+    glDeleteVertexArrays(1, &patchArray);
+}
+
+// The compute pass on the nodes of the current curve, checked vertex for vertex against
+// the CPU's adaptive tessellation for the editor's 640x640 window (same counts and layout)
+static void benchComputeTessellator(const DynamicBuffer &nodes, int npts)
+{
+    const float pixelScale = 320.0f;
+    ComputeTessellator tessellator;
+    createComputeTessellator(tessellator, computeProgram);
+    auto run = [&]
+    {
+        runComputeTessellator(tessellator, nodes, pixelScale, pixelScale, curveTolerance);
+    };
+    run();
+    while (computeTessellatorOverflowed(tessellator, true))
+        run();
+    bench("tessellate/compute", npts, [&]
+          {
+              run();
+              glFinish();
+          });
+    if (npts <= 100000)
+        bench("draw/compute-indirect", npts, [&]
+              {
+                  glUseProgram(curveProgram);
+                  glUniform4f(curveDequantizeLocation, 1.0f, 1.0f, 0.0f, 0.0f);
+                  drawComputeTessellator(tessellator);
+                  glFinish();
+              });
+
+    if (!filter || strstr("gpu compute error", filter))
+    {
+        int savedMode = tessellationMode;
+        tessellationMode = TESSELLATE_ADAPTIVE;
+        calculatePiecewiseBezier(); // ndcToPixelsX/Y are 320 as well
+        tessellationMode = savedMode;
+
+        GLuint command[5];
+        glBindBuffer(GL_COPY_READ_BUFFER, tessellator.command);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(command), command);
+        size_t vertices = std::min<size_t>(command[0], piecewiseBezier.size() / 2);
+        std::vector<float> gpu(2 * vertices);
+        glBindBuffer(GL_COPY_READ_BUFFER, tessellator.VBO);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, gpu.size() * sizeof(float), gpu.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        double maxError = 0.0;
+        for (size_t i = 0; i < gpu.size(); i++)
+            maxError = std::max(maxError, std::fabs((double)gpu[i] - piecewiseBezier[i]));
+        printf("  gpu compute %d segments: %u vertices drawn indirectly (CPU adaptive: %zu), max error %.3g px\n",
+               npts - 1, command[0], piecewiseBezier.size() / 2, pixelScale * maxError);
+    }
+    destroyComputeTessellator(tessellator);
+}
+#endif
+
+static void runSize(int npts)
+{
+    makeCurve(npts);
+    const float *xs = curveDocument.x.data(), *ys = curveDocument.y.data();
+    showTangents = true;
+
+    bench("calculateControlPolyline", npts, []
+          { calculateControlPolyline(); });
+
+    const char *tessellationNames[] = {"calculatePiecewiseBezier/direct", "calculatePiecewiseBezier/forward",
+                                       "calculatePiecewiseBezier/adaptive"};
+    for (int mode = TESSELLATE_DIRECT; mode <= TESSELLATE_ADAPTIVE; mode++)
+    {
+        tessellationMode = mode;
+        bench(tessellationNames[mode], npts, []
+              { calculatePiecewiseBezier(); });
+    }
+    tessellationMode = TESSELLATE_DIRECT;
+    calculateControlPolyline();
+    calculatePiecewiseBezier();
+
+    bench("calculateTangentVisuals", npts, []
+          { calculateTangentVisuals(); });
+
+    tangentMode = TANGENTS_NATURAL_SPLINE;
+    bench("calculatePiecewiseBezier/natural", npts, []
+          { calculatePiecewiseBezier(); });
+    tangentMode = TANGENTS_CENTRAL_DIFFERENCE;
+    calculatePiecewiseBezier();
+
+    // The natural spline tangents alone, solved serially and partitioned across the
+    // thread pool, checked against each other and against the system they solve
+    std::vector<point2d> splineNodes(npts), thomas(npts), partitioned(npts);
+    for (int i = 0; i < npts; i++)
+        splineNodes[i] = curveDocumentNdc(curveDocument, i);
+    SplineWorkspace work;
+    int parts = 4 * globalThreadPool().size();
+    bench("naturalSpline/thomas", npts, [&]
+          { solveNaturalSplineThomas(splineNodes.data(), npts, thomas.data(), work); });
+    bench("naturalSpline/partitioned", npts, [&]
+          { solveNaturalSplinePartitioned(splineNodes.data(), npts, partitioned.data(), work, parts); });
+    if (!filter || strstr("natural spline error", filter))
+    {
+        solveNaturalSplineThomas(splineNodes.data(), npts, thomas.data(), work);
+        solveNaturalSplinePartitioned(splineNodes.data(), npts, partitioned.data(), work, parts);
+        double difference = 0.0, residual = 0.0;
+        for (int i = 0; i < npts; i++)
+        {
+            difference = std::max({difference, std::fabs((double)partitioned[i].x - thomas[i].x),
+                                   std::fabs((double)partitioned[i].y - thomas[i].y)});
+            // Row i of the system, in double: what is left is the jump in second derivative
+            int prev = std::max(0, i - 1), next = std::min(npts - 1, i + 1);
+            double diagonal = (i == 0 || i == npts - 1) ? 2.0 : 4.0;
+            for (int axis = 0; axis < 2; axis++)
+            {
+                auto coord = [axis](const point2d &p) { return axis ? (double)p.y : (double)p.x; };
+                double row = diagonal * coord(thomas[i]) + (i > 0 ? coord(thomas[prev]) : 0.0) +
+                             (i < npts - 1 ? coord(thomas[next]) : 0.0) - 3.0 * (coord(splineNodes[next]) - coord(splineNodes[prev]));
+                residual = std::max(residual, std::fabs(row));
+            }
+        }
+        double thomasNs = medianNs("naturalSpline/thomas", npts), partitionedNs = medianNs("naturalSpline/partitioned", npts);
+        printf("  natural spline %d points: %.1f M points/s Thomas, %.1f M points/s partitioned (%d parts, %u threads), "
+               "max difference %.3g px, max residual %.3g px\n",
+               npts, thomasNs > 0.0 ? npts / thomasNs * 1e3 : 0.0, partitionedNs > 0.0 ? npts / partitionedNs * 1e3 : 0.0,
+               std::min(parts, npts / 3), globalThreadPool().size(), 320.0 * difference, 320.0 * residual);
+    }
+
+    // A drag of the middle point: what the editor does on every mouse move
+    int dragged = npts / 2;
+    float step = 0.0f;
+    bench("updateCurve/drag", npts, [&]
+          {
+              step += 0.1f;
+              curveDocument.x[dragged] += 0.3f * std::cos(step);
+              markControlPointDirty(dragged);
+              vertexRange points, polyline, curve, tangents;
+              updateCurve(points, polyline, curve, tangents);
+          });
+
+    // The same drag on natural spline tangents, patched near the moved point, then
+    // compared with a full solve of where the points ended up
+    tangentMode = TANGENTS_NATURAL_SPLINE;
+    calculatePiecewiseBezier();
+    int rebuilds = 0;
+    float dragError = 0.0f;
+    bench("updateCurve/drag natural", npts, [&]
+          {
+              step += 0.1f;
+              curveDocument.x[dragged] += 0.3f * std::cos(step);
+              markControlPointDirty(dragged);
+              vertexRange points, polyline, curve, tangents;
+              rebuilds += !updateCurve(points, polyline, curve, tangents);
+              dragError = std::max(dragError, splineDragError);
+          });
+    if (!filter || strstr("updateCurve/drag natural", filter))
+    {
+        std::vector<point2d> full(npts);
+        SplineWorkspace work;
+        solveNaturalSplineThomas(bezierNodes.data(), npts, full.data(), work);
+        double error = 0.0;
+        for (int i = 0; i < npts; i++)
+            error = std::max({error, std::fabs((double)bezierTangents[i].x - full[i].x),
+                              std::fabs((double)bezierTangents[i].y - full[i].y)});
+        // A tangent error e moves the curve by at most e / 4
+        printf("  natural spline drag %d points: max curve error %.3g px against a full solve, bound %.3g px, "
+               "%d full solves\n",
+               npts, 320.0 * error / 4.0, dragError, rebuilds);
+    }
+    tangentMode = TANGENTS_CENTRAL_DIFFERENCE;
+    calculatePiecewiseBezier();
+
+    // Picking, as searchNearestControlPoint() does it, at random positions near points
+    PointGrid grid;
+    pointGridInit(grid, 3.0f, 640.0f, 640.0f);
+    for (int i = 0; i < npts; i++)
+        pointGridInsert(grid, i, xs[i], ys[i]);
+    unsigned seed = 7;
+    bench("searchNearestControlPoint", npts, [&]
+          {
+              seed = seed * 1664525u + 1013904223u;
+              int i = seed % npts;
+              pointGridNearest(grid, xs, ys, xs[i] + 1.0f, ys[i] - 1.0f, 3.0f);
+          });
+
+    // Compact vertex formats: packing cost, and what the vertex shader sees versus float32
+    size_t vertices = piecewiseBezier.size() / 2;
+    VertexQuantization quantization = computeQuantization(piecewiseBezier.data(), vertices);
+    std::vector<uint16_t> packed(2 * vertices);
+    std::vector<float> unpacked(piecewiseBezier.size());
+    for (int format = VERTEX_FLOAT16; format < VERTEX_FORMAT_COUNT; format++)
+    {
+        std::string name = std::string("packVertices/") + vertexFormatName((VertexFormat)format);
+        bench(name.c_str(), npts, [&]
+              { packVertices((VertexFormat)format, quantization, piecewiseBezier.data(), vertices, packed.data()); });
+    }
+    if (!filter || strstr("vertex format error", filter))
+    {
+        for (int format = VERTEX_FLOAT32; format < VERTEX_FORMAT_COUNT; format++)
+        {
+            packVertices((VertexFormat)format, quantization, piecewiseBezier.data(), vertices,
+                         format == VERTEX_FLOAT32 ? (void *)unpacked.data() : (void *)packed.data());
+            unpackVertices((VertexFormat)format, quantization,
+                           format == VERTEX_FLOAT32 ? (void *)unpacked.data() : (void *)packed.data(), vertices, unpacked.data());
+            double maxError = 0.0, sumSquares = 0.0;
+            for (size_t i = 0; i < piecewiseBezier.size(); i++)
+            {
+                double e = std::fabs((double)unpacked[i] - piecewiseBezier[i]);
+                maxError = std::max(maxError, e);
+                sumSquares += e * e;
+            }
+            // 1 NDC unit is 320 px in the editor's 640x640 window
+            printf("  vertex format %-20s %2zu B/vertex, %8zu KiB: max error %.3g px, rms %.3g px\n",
+                   vertexFormatName((VertexFormat)format), vertexFormatBytes((VertexFormat)format),
+                   vertices * vertexFormatBytes((VertexFormat)format) / 1024, 320.0 * maxError,
+                   320.0 * std::sqrt(sumSquares / std::max<size_t>(1, piecewiseBezier.size())));
+        }
+    }
+
+#if HAVE_HEADLESS_GL
+    if (!haveGL)
+        return;
+
+    // Uploads of the tessellated curve: the original glBufferData per update,
+    // then DynamicBuffer with a full and with a drag-sized partial upload
+    DynamicBuffer buffer;
+    createDynamicBuffer(buffer);
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    bench("upload/glBufferData", npts, [&]
+          {
+              glBindBuffer(GL_ARRAY_BUFFER, vbo);
+              glBufferData(GL_ARRAY_BUFFER, piecewiseBezier.size() * sizeof(float), piecewiseBezier.data(), GL_DYNAMIC_DRAW);
+              glFinish();
+          });
+    size_t dragFloats = std::min(piecewiseBezier.size(), (size_t)2 * 4 * (SAMPLES_PER_BEZIER - 1) + 2);
+    const char *formatSuffix[] = {"", "/float16", "/snorm16"};
+    for (int format = VERTEX_FLOAT32; format < VERTEX_FORMAT_COUNT; format++)
+    {
+        setDynamicBufferFormat(buffer, (VertexFormat)format);
+        std::string full = std::string("upload/dynamic-full") + formatSuffix[format];
+        std::string drag = std::string("upload/dynamic-drag") + formatSuffix[format];
+        bench(full.c_str(), npts, [&]
+              {
+                  uploadDynamicBuffer(buffer, piecewiseBezier);
+                  glFinish();
+              });
+        bench(drag.c_str(), npts, [&]
+              {
+                  uploadDynamicBuffer(buffer, piecewiseBezier, piecewiseBezier.size() / 2 / 2 * 2, dragFloats);
+                  glFinish();
+              });
+    }
+    glDeleteBuffers(1, &vbo);
+
+    // Drawing the curve: tessellated on the CPU and uploaded as vertices (the draw of
+    // the buffer above), or evaluated by bezier.vs from the nodes alone
+    setDynamicBufferFormat(buffer, VERTEX_FLOAT32);
+    uploadDynamicBuffer(buffer, piecewiseBezier);
+    std::vector<float> cpuCurve = piecewiseBezier;
+    gpuBezierEvaluation = true;
+    bench("calculatePiecewiseBezier/gpu-nodes", npts, []
+          { calculatePiecewiseBezier(); });
+    calculatePiecewiseBezier(); // The nodes, also when the filter skipped the line above
+    gpuBezierEvaluation = false;
+    DynamicBuffer nodes;
+    createDynamicBuffer(nodes);
+    setBezierNodeLayout(nodes);
+    bench("upload/gpu-nodes-full", npts, [&]
+          {
+              uploadDynamicBuffer(nodes, bezierNodeVertices);
+              glFinish();
+          });
+    uploadDynamicBuffer(nodes, bezierNodeVertices);
+    if (npts <= 100000) // Software rasterization of longer curves takes seconds per draw
+    {
+        bench("draw/cpu-tessellated", npts, [&]
+              {
+                  glUseProgram(curveProgram);
+                  glBindVertexArray(buffer.VAO);
+                  setDequantizeUniform(buffer, curveDequantizeLocation);
+                  glDrawArrays(GL_LINE_STRIP, 0, cpuCurve.size() / 2);
+                  glFinish();
+              });
+        bench("draw/gpu-evaluated", npts, [&]
+              {
+                  glUseProgram(bezierProgram);
+                  drawBezierSegments(nodes, bezierSamplesLocation, SAMPLES_PER_BEZIER);
+                  glFinish();
+              });
+    }
+
+    // What bezier.vs computes, captured with transform feedback, against the CPU curve.
+    // Sample k of segment i is vertex i * (samples - 1) + k of the CPU curve.
+    int segments = npts - 1, samples = SAMPLES_PER_BEZIER;
+    size_t captured = (size_t)segments * samples;
+    if ((!filter || strstr("gpu bezier error", filter)) && captured <= (1u << 24))
+    {
+        GLuint feedback;
+        glGenBuffers(1, &feedback);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+        glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, captured * 4 * sizeof(float), nullptr, GL_STREAM_READ);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback);
+        glUseProgram(bezierProgram);
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBeginTransformFeedback(GL_POINTS);
+        drawBezierSegments(nodes, bezierSamplesLocation, samples, GL_POINTS);
+        glEndTransformFeedback();
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        const float *gpu = (const float *)glMapBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captured * 4 * sizeof(float), GL_MAP_READ_BIT);
+        double maxError = 0.0;
+        for (size_t v = 0; gpu && v < captured; v++)
+        {
+            size_t cpu = v / samples * (samples - 1) + v % samples;
+            for (int axis = 0; axis < 2; axis++)
+                maxError = std::max(maxError, std::fabs((double)gpu[4 * v + axis] - cpuCurve[2 * cpu + axis]));
+        }
+        glUnmapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER);
+        glDeleteBuffers(1, &feedback);
+        printf("  gpu bezier %d segments x %d samples: %zu vertices in %zu KiB of nodes instead of %zu KiB, max error %.3g px\n",
+               segments, samples, captured, bezierNodeVertices.size() * sizeof(float) / 1024,
+               cpuCurve.size() * sizeof(float) / 1024, gpu ? 320.0 * maxError : -1.0);
+    }
+    if (tessellationProgram)
+        benchTessellationShaders(nodes, npts);
+    if (computeProgram && npts <= 1000000)
+        benchComputeTessellator(nodes, npts);
+    glUseProgram(0);
+    destroyDynamicBuffer(nodes);
+    destroyDynamicBuffer(buffer);
+    calculatePiecewiseBezier();
+#endif
+}
+
+static void writeJson(const char *filename)
+{
+    FILE *out = fopen(filename, "w");
+    if (out == NULL)
+    {
+        perror(filename);
+        return;
+    }
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"points\": %d, \"repetitions\": %d, \"min_ns\": %.1f, "
+                     "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"mean_ns\": %.1f}%s\n",
+                r.name.c_str(), r.points, r.repetitions, r.minNs, r.medianNs, r.p99Ns, r.meanNs,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+}
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--sizes 10,100,...] [--max-points N] [--repetitions N] "
+                    "[--filter substring] [--json file]\n",
+            program);
+    return 2;
+}
+
+// A whole decimal number of at least minimum, up to the first of terminators; false if malformed
+static bool parseCount(const char *text, int minimum, const char *terminators, int &count, const char **rest)
+{
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || errno != 0 || value < minimum || value > INT_MAX || !strchr(terminators, *end))
+        return false;
+    count = (int)value;
+    *rest = end;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> sizes = {10, 100, 1000, 10000, 100000, 1000000, 10000000};
+    int maxPoints = 10000000;
+    const char *jsonFile = nullptr;
+
+    for (int a = 1; a < argc; a++)
+    {
+        const char *arg = argv[a];
+        if (strcmp(arg, "--sizes") && strcmp(arg, "--max-points") && strcmp(arg, "--repetitions") &&
+            strcmp(arg, "--filter") && strcmp(arg, "--json"))
+        {
+            fprintf(stderr, "%s: unknown option %s\n", argv[0], arg);
+            return usage(argv[0]);
+        }
+        if (a + 1 >= argc)
+            return usage(argv[0]);
+        const char *value = argv[++a], *rest;
+        if (!strcmp(arg, "--sizes"))
+        {
+            // Every entry a whole number of at least 2 points: "1e6" or "10k" is an error, not 1 or 10
+            sizes.clear();
+            for (const char *p = value;; p = rest + 1)
+            {
+                int npts;
+                if (!parseCount(p, 2, ",", npts, &rest))
+                {
+                    fprintf(stderr, "%s: --sizes wants whole numbers of at least 2 points, got %s\n", argv[0], value);
+                    return usage(argv[0]);
+                }
+                sizes.push_back(npts);
+                if (*rest == '\0')
+                    break;
+            }
+        }
+        else if (!strcmp(arg, "--max-points") || !strcmp(arg, "--repetitions"))
+        {
+            int count;
+            if (!parseCount(value, 1, "", count, &rest))
+            {
+                fprintf(stderr, "%s: %s wants a positive whole number, got %s\n", argv[0], arg, value);
+                return usage(argv[0]);
+            }
+            if (!strcmp(arg, "--max-points"))
+                maxPoints = count;
+            else
+                repetitions = count;
+        }
+        else if (!strcmp(arg, "--filter"))
+            filter = value;
+        else
+            jsonFile = value;
+    }
+
+#if HAVE_HEADLESS_GL
+    haveGL = createHeadlessGLContext(3, 3) && initGLResources();
+    if (haveGL)
+        printf("GL: %s | %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+#else
+    printf("GL: not built with headless GL, skipping upload benchmarks\n");
+#endif
+
+    printf("%-34s %10s %14s %14s %14s %14s\n", "benchmark", "points", "min ns", "median ns", "p99 ns", "mean ns");
+    for (int npts : sizes)
+        if (npts <= maxPoints)
+            runSize(npts);
+
+    if (jsonFile)
+        writeJson(jsonFile);
+#if HAVE_HEADLESS_GL
+    if (haveGL)
+    {
+        destroyGLResources();
+        destroyHeadlessGLContext();
+    }
+#endif
+    return 0;
+}
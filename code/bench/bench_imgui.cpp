@@ -0,0 +1,171 @@
+// Measures the CPU cost of submitting a UI-heavy ImGui frame through the OpenGL 3
+// backend on a headless GL context: the vertices and indices uploaded with
+// glBufferData per command list versus written once per frame into the persistently
+// mapped ring buffer (GL 4.4+). Reports the median time spent in
+// ImGui_ImplOpenGL3_RenderDrawData, the calling thread's CPU time in it, and the
+// time until glFinish returns. Exits with status 1 if both paths do not render the
+// same pixels.
+//
+// The UI is laid out at 1280x800 but rasterized at framebuffer scale (default 1/4):
+// a software rasterizer like llvmpipe would otherwise bury the upload and draw call
+// cost under fill rate. llvmpipe also rasterizes on glFenceSync, so there only the
+// "until glFinish" column compares the paths fairly.
+//
+// Usage: bench_imgui [windows] [frames] [framebuffer scale]
+
+#include "glloader.h"
+#include "headlessgl.h"
+#include "imgui.h"
+#include "imgui_impl_opengl3.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+static const int width = 1280, height = 800;
+static GLuint targetFramebuffer = 0, targetColor = 0;
+
+static double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double threadCpuNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Overlapping windows full of text, sliders and plots; step animates the values
+static ImDrawData *buildFrame(int windows, int step)
+{
+    static float values[256];
+    for (int i = 0; i < 256; i++)
+        values[i] = (float)((i * 37 + step * 11) % 97) / 97.0f;
+
+    ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui::NewFrame();
+    for (int w = 0; w < windows; w++)
+    {
+        char title[32];
+        snprintf(title, sizeof(title), "Window %d", w);
+        ImGui::SetNextWindowPos(ImVec2((float)(w % 8) * 150.0f, (float)(w / 8 % 4) * 190.0f), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(300.0f, 380.0f), ImGuiCond_Always);
+        ImGui::Begin(title);
+        for (int row = 0; row < 12; row++)
+        {
+            float value = values[(w + row) & 255];
+            ImGui::Text("Row %d: %.3f", row, value);
+            ImGui::SliderFloat("##value", &value, 0.0f, 1.0f);
+            ImGui::ProgressBar(value);
+        }
+        ImGui::PlotLines("##plot", values, 256, 0, NULL, 0.0f, 1.0f, ImVec2(0.0f, 60.0f));
+        ImGui::End();
+    }
+    ImGui::Render();
+    return ImGui::GetDrawData();
+}
+
+struct FrameTimes
+{
+    double submitNs, submitCpuNs, frameNs; // frameNs: from submit until glFinish returns
+};
+
+static FrameTimes runFrames(int windows, int frames)
+{
+    std::vector<double> submit, submitCpu, frame;
+    for (int f = -10; f < frames; f++) // 10 frames of warm-up, which also grow the ring
+    {
+        ImDrawData *drawData = buildFrame(windows, f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glFinish();
+        double submitStart = nowNs(), submitCpuStart = threadCpuNs();
+        ImGui_ImplOpenGL3_RenderDrawData(drawData);
+        double submitEnd = nowNs(), submitCpuEnd = threadCpuNs();
+        glFinish();
+        if (f < 0)
+            continue;
+        submit.push_back(submitEnd - submitStart);
+        submitCpu.push_back(submitCpuEnd - submitCpuStart);
+        frame.push_back(nowNs() - submitStart);
+    }
+    auto median = [](std::vector<double> &v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    };
+    return FrameTimes{median(submit), median(submitCpu), median(frame)};
+}
+
+static std::vector<unsigned char> renderReference(int windows)
+{
+    ImDrawData *drawData = buildFrame(windows, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(drawData);
+    std::vector<unsigned char> pixels(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+int main(int argc, char *argv[])
+{
+    int windows = argc > 1 ? std::max(1, atoi(argv[1])) : 32;
+    int frames = argc > 2 ? std::max(1, atoi(argv[2])) : 200;
+    float scale = argc > 3 ? (float)atof(argv[3]) : 0.25f;
+
+    if (!createHeadlessGLContext(3, 3))
+        return 2;
+    printf("GL: %s | %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+
+    glGenRenderbuffers(1, &targetColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, targetColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &targetFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, targetColor);
+    glViewport(0, 0, width, height);
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    io.IniFilename = NULL;
+    io.DisplaySize = ImVec2((float)width, (float)height);
+    io.DisplayFramebufferScale = ImVec2(scale, scale);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
+
+    ImDrawData *drawData = buildFrame(windows, 0);
+    printf("%d windows: %d draw lists, %d vertices, %d indices per frame, %d frames\n", windows,
+           drawData->CmdListsCount, drawData->TotalVtxCount, drawData->TotalIdxCount, frames);
+    printf("%-22s %16s %16s %16s\n", "upload", "submit ns", "submit cpu ns", "finished ns");
+
+    int status = 0;
+    ImGui_ImplOpenGL3_SetPersistentBuffers(false);
+    FrameTimes bufferData = runFrames(windows, frames);
+    printf("%-22s %16.0f %16.0f %16.0f\n", "glBufferData", bufferData.submitNs, bufferData.submitCpuNs,
+           bufferData.frameNs);
+    std::vector<unsigned char> expected = renderReference(windows);
+
+    if (ImGui_ImplOpenGL3_SetPersistentBuffers(true))
+    {
+        FrameTimes ring = runFrames(windows, frames);
+        printf("%-22s %16.0f %16.0f %16.0f\n", "persistent ring", ring.submitNs, ring.submitCpuNs, ring.frameNs);
+        printf("until glFinish: %.2fx faster\n", bufferData.frameNs / ring.frameNs);
+        if (renderReference(windows) != expected)
+        {
+            printf("FAIL: the ring buffer path rendered different pixels\n");
+            status = 1;
+        }
+    }
+    else
+        printf("persistent ring: needs OpenGL 4.4, skipped\n");
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+    glDeleteFramebuffers(1, &targetFramebuffer);
+    glDeleteRenderbuffers(1, &targetColor);
+    destroyHeadlessGLContext();
+    return status;
+}
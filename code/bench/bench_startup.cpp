@@ -0,0 +1,213 @@
+// Time to first frame of the editor on a headless context: context creation, the
+// ImGui font atlas and OpenGL backend, every GL program of the editor, then a first
+// frame of the curve shader and an ImGui window. Runs each start cold (empty caches:
+// rasterize the fonts, compile and link from the embedded sources) and warm (font
+// atlas and programs loaded from their caches), both serially and overlapped the
+// way the editor starts: the atlas built on a worker while the context is created
+// (startup.h), the programs issued up front and waited for once ImGui has started up
+// (startEditorPrograms, which the driver can compile in parallel). Reports the median time
+// since the start at the end of each phase on the main thread. Exits with status 1
+// if a cache misses when warm, or if a start draws different pixels or builds a
+// different font atlas than the cold serial one.
+//
+// Mesa only offers program binaries while its own on-disk shader cache is enabled,
+// and that cache already speeds up the "cold" compiles: they are a lower bound.
+//
+// Usage: bench_startup [repetitions] [cache directory]
+
+#include "glloader.h"
+#include "headlessgl.h"
+#include "imgui.h"
+#include "imgui_impl_opengl3.h"
+#include "programcache.h"
+#include "shaderprogram.h"
+#include "startup.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static const int width = 640, height = 640;
+
+struct StartupTimes
+{
+    double contextMs, fontsMs, programsMs, firstFrameMs; // Each since the start
+    int programs, cached;                                 // Programs built, of which loaded from the cache
+    bool cacheEnabled, fontsCached;
+    std::vector<unsigned char> pixels, fontAtlas; // First frame; atlas texture followed by the glyphs
+};
+
+static StartupTimes startUp(const char *cacheDirectory, bool overlapped)
+{
+    StartupTimes times = {};
+    startupBegin();
+    startFontAtlasBuild(cacheDirectory, NULL, overlapped);
+    if (!createHeadlessGLContext(3, 3))
+        exit(2);
+    times.contextMs = startupElapsedMs();
+
+    programCacheInit(cacheDirectory);
+    times.cacheEnabled = programCacheEnabled();
+    GLuint programs[EDITOR_PROGRAM_COUNT];
+    startEditorPrograms();
+    if (!overlapped)
+        finishEditorPrograms(programs);
+
+    ImFontAtlas *atlas = finishFontAtlasBuild(NULL, &times.fontsCached);
+    times.fontsMs = startupElapsedMs();
+    times.fontAtlas.assign(atlas->TexPixelsAlpha8, atlas->TexPixelsAlpha8 + atlas->TexWidth * atlas->TexHeight);
+    for (const ImFont *font : atlas->Fonts)
+    {
+        const unsigned char *glyphs = (const unsigned char *)font->Glyphs.Data;
+        times.fontAtlas.insert(times.fontAtlas.end(), glyphs, glyphs + font->Glyphs.size_in_bytes());
+    }
+    ImGui::CreateContext(atlas);
+    ImGuiIO &io = ImGui::GetIO();
+    io.IniFilename = NULL;
+    io.DisplaySize = ImVec2((float)width, (float)height);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
+    ImGui_ImplOpenGL3_CreateDeviceObjects();
+
+    GLuint framebuffer, color, VAO, VBO;
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glViewport(0, 0, width, height);
+    const float triangle[6] = {-0.5f, -0.5f, 0.5f, -0.5f, 0.0f, 0.5f};
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    if (overlapped)
+        finishEditorPrograms(programs);
+    times.programsMs = startupElapsedMs();
+    for (GLuint program : programs)
+    {
+        if (program == 0)
+        {
+            printf("FAIL: a program did not build\n");
+            exit(1);
+        }
+        GLint attached = 0;
+        glGetProgramiv(program, GL_ATTACHED_SHADERS, &attached);
+        times.programs++;
+        times.cached += attached == 0; // glProgramBinary programs have no shader objects
+    }
+
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(programs[PROGRAM_CURVE]);
+    glUniform4f(glGetUniformLocation(programs[PROGRAM_CURVE], "dequantize"), 1.0f, 1.0f, 0.0f, 0.0f);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    bool showTangents = false;
+    int samples = 32;
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui::NewFrame();
+    ImGui::Begin("Options");
+    ImGui::Checkbox("Show Tangents", &showTangents);
+    ImGui::SliderInt("GPU samples", &samples, 2, 128);
+    ImGui::Text("Curve vertices: %d", 0);
+    ImGui::End();
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    times.pixels.resize(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, times.pixels.data());
+    times.firstFrameMs = startupElapsedMs();
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+    IM_DELETE(atlas);
+    glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &color);
+    for (GLuint program : programs)
+        glDeleteProgram(program);
+    destroyHeadlessGLContext();
+    return times;
+}
+
+static double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    int repetitions = argc > 1 ? std::max(1, atoi(argv[1])) : 10;
+    std::string directory = argc > 2 ? argv[2] : (std::filesystem::temp_directory_path() / "bench_startup_cache").string();
+
+    int status = 0;
+    std::vector<unsigned char> expected, expectedFontAtlas;
+    printf("%-6s %-10s %11s %9s %12s %15s %9s %7s\n", "start", "startup", "context ms", "fonts ms", "programs ms",
+           "first frame ms", "programs", "fonts");
+    for (int warm = 0; warm < 2; warm++)
+    {
+        // Alternate serial and overlapped starts, so that both see the same load on the machine
+        std::vector<double> context[2], fonts[2], programs[2], firstFrame[2];
+        StartupTimes times[2];
+        if (warm)
+            startUp(directory.c_str(), false); // Fill the caches
+        for (int r = 0; r < repetitions; r++)
+        {
+            for (int overlapped = 0; overlapped < 2; overlapped++)
+            {
+                if (!warm)
+                    std::filesystem::remove_all(directory);
+                times[overlapped] = startUp(directory.c_str(), overlapped);
+                context[overlapped].push_back(times[overlapped].contextMs);
+                fonts[overlapped].push_back(times[overlapped].fontsMs);
+                programs[overlapped].push_back(times[overlapped].programsMs);
+                firstFrame[overlapped].push_back(times[overlapped].firstFrameMs);
+            }
+        }
+
+        for (int overlapped = 0; overlapped < 2; overlapped++)
+        {
+            const StartupTimes &t = times[overlapped];
+            printf("%-6s %-10s %11.2f %9.2f %12.2f %15.2f %7d/%d %7s\n", warm ? "warm" : "cold",
+                   overlapped ? "overlapped" : "serial", median(context[overlapped]), median(fonts[overlapped]),
+                   median(programs[overlapped]), median(firstFrame[overlapped]), t.cached, t.programs,
+                   t.fontsCached ? "cached" : "built");
+            if (!warm && !overlapped)
+            {
+                expected = t.pixels;
+                expectedFontAtlas = t.fontAtlas;
+                continue;
+            }
+            if (t.pixels != expected || t.fontAtlas != expectedFontAtlas)
+            {
+                printf("FAIL: %s\n", t.pixels != expected ? "the first frame differs" : "the font atlas differs");
+                status = 1;
+            }
+            if (!warm)
+                continue;
+            if (!t.fontsCached)
+            {
+                printf("FAIL: the font atlas missed the cache\n");
+                status = 1;
+            }
+            if (!t.cacheEnabled)
+                printf("warm: the context has no program binary formats, no program is cached\n");
+            else if (t.cached != t.programs)
+            {
+                printf("FAIL: programs missed the cache\n");
+                status = 1;
+            }
+        }
+        printf("%s time to first frame: %.2f ms serial, %.2f ms overlapped\n", warm ? "warm" : "cold",
+               median(firstFrame[0]), median(firstFrame[1]));
+    }
+    std::filesystem::remove_all(directory);
+    return status;
+}
@@ -0,0 +1,127 @@
+// Throughput of the cubic segment samplers (SIMD levels and forward differencing)
+// against the original per-sample Bernstein loop of calculatePiecewiseBezier().
+//
+// Usage: bench_tessellate [segments] [samples per segment]
+
+#include "tessellate.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static void sampleCubicReference(const point2d ctrl[4], int samples, int firstSample, float *out)
+{
+    float interval = 1.0f / (samples - 1);
+    for (int k = firstSample; k < samples; ++k, out += 2)
+    {
+        float t = k * interval;
+        float v = 1.0f - t;
+        float b0 = v * v * v;
+        float b1 = 3.0f * v * v * t;
+        float b2 = 3.0f * v * t * t;
+        float b3 = t * t * t;
+
+        out[0] = b0 * ctrl[0].x + b1 * ctrl[1].x + b2 * ctrl[2].x + b3 * ctrl[3].x;
+        out[1] = b0 * ctrl[0].y + b1 * ctrl[1].y + b2 * ctrl[2].y + b3 * ctrl[3].y;
+    }
+}
+
+template <typename F>
+static double bestSeconds(F run, int repetitions)
+{
+    double best = 1e30;
+    run(); // Warm up caches and page in the output
+    for (int r = 0; r < repetitions; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int segments = argc > 1 ? atoi(argv[1]) : 100000;
+    int samples = argc > 2 ? atoi(argv[2]) : 10;
+    if (segments < 1 || samples < 2)
+    {
+        fprintf(stderr, "usage: %s [segments >= 1] [samples >= 2]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<point2d> ctrl(4 * segments);
+    srand(1);
+    for (point2d &p : ctrl)
+        p = {rand() / (float)RAND_MAX * 2.0f - 1.0f, rand() / (float)RAND_MAX * 2.0f - 1.0f};
+
+    BernsteinTable table;
+    buildBernsteinTable(table, samples);
+
+    size_t perSegment = 2 * (samples - 1);
+    std::vector<float> expected(perSegment * segments + 2), out(expected.size());
+    auto sampleAll = [&](std::vector<float> &dst, CubicSampler sampler)
+    {
+        for (int i = 0; i < segments; i++)
+        {
+            int first = i > 0 ? 1 : 0;
+            float *o = &dst[perSegment * i + 2 * first];
+            if (sampler)
+                sampler(&ctrl[4 * i], table, first, o);
+            else
+                sampleCubicReference(&ctrl[4 * i], samples, first, o);
+        }
+    };
+
+    double total = (double)segments * (samples - 1) + 1;
+    int repetitions = 10;
+    double reference = bestSeconds([&]
+                                   { sampleAll(expected, nullptr); },
+                                   repetitions);
+    printf("%d segments x %d samples, best of %d\n", segments, samples, repetitions);
+    printf("%-12s %10.2f Msamples/s\n", "reference", total / reference * 1e-6);
+
+    SimdLevel supported = detectSimdLevel();
+    auto report = [&](const char *name, CubicSampler sampler)
+    {
+        double seconds = bestSeconds([&]
+                                     { sampleAll(out, sampler); },
+                                     repetitions);
+
+        float maxError = 0.0f;
+        for (size_t j = 0; j < out.size(); j++)
+            maxError = std::max(maxError, std::fabs(out[j] - expected[j]));
+        printf("%-12s %10.2f Msamples/s  %5.2fx  max error %g\n", name,
+               total / seconds * 1e-6, reference / seconds, maxError);
+    };
+    for (int level = SIMD_SCALAR; level <= supported; level++)
+        report(simdLevelName((SimdLevel)level), getCubicSampler((SimdLevel)level));
+    report("forward-diff", getTessellationSampler(TESSELLATE_FORWARD_DIFFERENCE));
+    if (CubicSampler fixed = getFixedCubicSampler(samples))
+        report("constexpr", fixed);
+    else
+        printf("%-12s no specialization for %d samples\n", "constexpr", samples);
+
+    // Adaptive mode on an editor-like curve: a random walk of clicks ~50 px apart with
+    // central-difference tangents, on a 640x640 window with ImGui's default 1.25 px tolerance
+    std::vector<point2d> nodes(segments + 1);
+    for (int i = 1; i <= segments; i++)
+        nodes[i] = {nodes[i - 1].x + (rand() / (float)RAND_MAX - 0.5f) * 0.3f,
+                    nodes[i - 1].y + (rand() / (float)RAND_MAX - 0.5f) * 0.3f};
+    size_t adaptiveVertices = 1;
+    for (int i = 0; i < segments; i++)
+    {
+        point2d t0 = i > 0 ? point2d{(nodes[i + 1].x - nodes[i - 1].x) * 0.5f, (nodes[i + 1].y - nodes[i - 1].y) * 0.5f}
+                           : point2d{nodes[1].x - nodes[0].x, nodes[1].y - nodes[0].y};
+        point2d t1 = i + 1 < segments ? point2d{(nodes[i + 2].x - nodes[i].x) * 0.5f, (nodes[i + 2].y - nodes[i].y) * 0.5f}
+                                      : point2d{nodes[i + 1].x - nodes[i].x, nodes[i + 1].y - nodes[i].y};
+        point2d seg[4] = {nodes[i], {nodes[i].x + t0.x / 3.0f, nodes[i].y + t0.y / 3.0f},
+                          {nodes[i + 1].x - t1.x / 3.0f, nodes[i + 1].y - t1.y / 3.0f}, nodes[i + 1]};
+        adaptiveVertices += adaptiveSampleCount(seg, 320.0f, 320.0f, 1.25f, 1024) - 1;
+    }
+    printf("%-12s %10.0f vertices fixed, %zu adaptive (editor-like curve, 1.25 px at 640x640)\n",
+           "adaptive", total, adaptiveVertices);
+    return 0;
+}
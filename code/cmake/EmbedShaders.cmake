@@ -0,0 +1,26 @@
+# Writes OUTPUT, a C++ source defining every shader in SHADERS (a ;-separated list
+# of files separated by |) as a constexpr string, plus the embeddedShaders table of
+# embeddedshaders.h. Run as: cmake -DOUTPUT=file.cpp -DSHADERS="a.vs|b.fs" -P EmbedShaders.cmake
+
+string(REPLACE "|" ";" SHADERS "${SHADERS}")
+
+set(content "// Generated from shaders/ by cmake/EmbedShaders.cmake, do not edit\n#include \"embeddedshaders.h\"\n\n")
+set(table "")
+set(count 0)
+foreach(shader ${SHADERS})
+	get_filename_component(name ${shader} NAME)
+	string(MAKE_C_IDENTIFIER ${name} identifier)
+	file(READ ${shader} source)
+	string(APPEND content "static constexpr char ${identifier}[] = R\"shader(${source})shader\";\n")
+	string(APPEND table "\t{\"${name}\", ${identifier}},\n")
+	math(EXPR count "${count} + 1")
+endforeach()
+string(APPEND content "\nconst EmbeddedShader embeddedShaders[] = {\n${table}};\nconst int embeddedShaderCount = ${count};\n")
+
+# Leave an unchanged file alone so dependents don't rebuild
+if(EXISTS ${OUTPUT})
+	file(READ ${OUTPUT} previous)
+endif()
+if(NOT "${previous}" STREQUAL "${content}")
+	file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -13,6 +13,7 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  (local)     OpenGL: Desktop GL 4.4+ only: Upload the whole frame through a triple-buffered, persistently mapped ring buffer instead of glBufferData() per command list. Added ImGui_ImplOpenGL3_SetPersistentBuffers().
 //  2020-07-10: OpenGL: Added support for glad2 OpenGL loader.
 //  2020-05-08: OpenGL: Made default GLSL version 150 (instead of 130) on OSX.
 //  2020-04-21: OpenGL: Fixed handling of glClipControl(GL_UPPER_LEFT) by inverting projection matrix.
@@ -130,6 +131,13 @@ using namespace gl;
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET   1
 #endif
 
+// Desktop GL 4.4+ has glBufferStorage() with persistent mappings, which GL ES and WebGL don't have.
+#if defined(IMGUI_IMPL_OPENGL_ES2) || defined(IMGUI_IMPL_OPENGL_ES3) || !IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET || !defined(GL_MAP_PERSISTENT_BIT)
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE   0
+#else
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE   1
+#endif
+
 // OpenGL Data
 static GLuint       g_GlVersion = 0;                // Extracted at runtime using GL_MAJOR_VERSION, GL_MINOR_VERSION queries (e.g. 320 for GL 3.2)
 static char         g_GlslVersionString[32] = "";   // Specified by user or detected based on compile time GL settings.
@@ -138,6 +146,19 @@ static GLuint       g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
 static GLint        g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;                                // Uniforms location
 static GLuint       g_AttribLocationVtxPos = 0, g_AttribLocationVtxUV = 0, g_AttribLocationVtxColor = 0; // Vertex attributes location
 static unsigned int g_VboHandle = 0, g_ElementsHandle = 0;
+static bool         g_UsePersistentBuffers = true;  // Changed with ImGui_ImplOpenGL3_SetPersistentBuffers()
+
+#if IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+// Ring buffer: while active, g_VboHandle/g_ElementsHandle are immutable buffers split in IMGUI_IMPL_OPENGL_RING_FRAMES
+// regions that stay mapped. A frame writes all its vertices/indices in one region, then fences it until the GPU is done.
+#define IMGUI_IMPL_OPENGL_RING_FRAMES 3
+static bool         g_RingActive = false;
+static ImDrawVert*  g_RingVtxData = NULL;           // Mapped g_VboHandle
+static ImDrawIdx*   g_RingIdxData = NULL;           // Mapped g_ElementsHandle
+static int          g_RingVtxCapacity = 0, g_RingIdxCapacity = 0; // Per region
+static int          g_RingFrame = 0;                // Region the next frame writes to
+static GLsync       g_RingFences[IMGUI_IMPL_OPENGL_RING_FRAMES] = {};
+#endif
 
 // Functions
 bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
@@ -283,6 +304,99 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     glVertexAttribPointer(g_AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, col));
 }
 
+#if IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+static void ImGui_ImplOpenGL3_WaitRingFence(int frame)
+{
+    if (g_RingFences[frame] == 0)
+        return;
+    while (glClientWaitSync(g_RingFences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(g_RingFences[frame]);
+    g_RingFences[frame] = 0;
+}
+
+// Replace the ring with plain buffers again (mapped buffers are unmapped when deleted).
+static void ImGui_ImplOpenGL3_DestroyRing()
+{
+    for (int frame = 0; frame < IMGUI_IMPL_OPENGL_RING_FRAMES; frame++)
+        ImGui_ImplOpenGL3_WaitRingFence(frame);
+    glDeleteBuffers(1, &g_VboHandle);
+    glDeleteBuffers(1, &g_ElementsHandle);
+    glGenBuffers(1, &g_VboHandle);
+    glGenBuffers(1, &g_ElementsHandle);
+    g_RingActive = false;
+    g_RingVtxData = NULL;
+    g_RingIdxData = NULL;
+    g_RingVtxCapacity = g_RingIdxCapacity = 0;
+    g_RingFrame = 0;
+}
+
+// Immutable storage can't be resized: recreate both buffers with room for vtx_capacity/idx_capacity per region.
+// Binds them to GL_COPY_WRITE_BUFFER so that the element array binding of the user's VAO is left alone.
+static bool ImGui_ImplOpenGL3_CreateRing(int vtx_capacity, int idx_capacity)
+{
+    ImGui_ImplOpenGL3_DestroyRing();
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr vtx_size = (GLsizeiptr)vtx_capacity * IMGUI_IMPL_OPENGL_RING_FRAMES * (int)sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)idx_capacity * IMGUI_IMPL_OPENGL_RING_FRAMES * (int)sizeof(ImDrawIdx);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_VboHandle);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, vtx_size, NULL, flags);
+    g_RingVtxData = (ImDrawVert*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, vtx_size, flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_ElementsHandle);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, idx_size, NULL, flags);
+    g_RingIdxData = (ImDrawIdx*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, idx_size, flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (g_RingVtxData == NULL || g_RingIdxData == NULL)
+    {
+        ImGui_ImplOpenGL3_DestroyRing();
+        return false;
+    }
+    g_RingActive = true;
+    g_RingVtxCapacity = vtx_capacity;
+    g_RingIdxCapacity = idx_capacity;
+    return true;
+}
+
+// Copy the vertices/indices of every command list, back to back, into the next free region.
+// Returns false if the ring can't be used, in which case the caller uploads with glBufferData().
+static bool ImGui_ImplOpenGL3_UploadRing(ImDrawData* draw_data, int* vtx_base, int* idx_base)
+{
+    if (!g_RingActive || draw_data->TotalVtxCount > g_RingVtxCapacity || draw_data->TotalIdxCount > g_RingIdxCapacity)
+    {
+        // Grow geometrically so that a window opening doesn't recreate the buffers every frame
+        int vtx_capacity = g_RingVtxCapacity > 0 ? g_RingVtxCapacity * 2 : 1 << 14;
+        int idx_capacity = g_RingIdxCapacity > 0 ? g_RingIdxCapacity * 2 : 1 << 15;
+        while (vtx_capacity < draw_data->TotalVtxCount) vtx_capacity *= 2;
+        while (idx_capacity < draw_data->TotalIdxCount) idx_capacity *= 2;
+        if (!ImGui_ImplOpenGL3_CreateRing(vtx_capacity, idx_capacity))
+            return false;
+    }
+    ImGui_ImplOpenGL3_WaitRingFence(g_RingFrame);
+    *vtx_base = g_RingFrame * g_RingVtxCapacity;
+    *idx_base = g_RingFrame * g_RingIdxCapacity;
+    ImDrawVert* vtx_dst = g_RingVtxData + *vtx_base;
+    ImDrawIdx* idx_dst = g_RingIdxData + *idx_base;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        memcpy(vtx_dst, cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(idx_dst, cmd_list->IdxBuffer.Data, (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        vtx_dst += cmd_list->VtxBuffer.Size;
+        idx_dst += cmd_list->IdxBuffer.Size;
+    }
+    return true;
+}
+#endif
+
+bool    ImGui_ImplOpenGL3_SetPersistentBuffers(bool enable)
+{
+    g_UsePersistentBuffers = enable;
+#if IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    return enable && g_GlVersion >= 440;
+#else
+    return false;
+#endif
+}
+
 // OpenGL3 Render function.
 // (this used to be set in io.RenderDrawListsFn and called by ImGui::Render(), but you can now call this directly from your main loop)
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly, in order to be able to run within any OpenGL engine that doesn't do so.
@@ -322,6 +436,18 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
     GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
     GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
 
+    // Upload the whole frame at once into the ring buffer when available. The ring is (re)created
+    // here, before the buffers are bound for drawing.
+    // vtx_base/idx_base: where the current command list starts in the bound buffers.
+    bool use_ring = false;
+    int vtx_base = 0, idx_base = 0;
+#if IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (g_UsePersistentBuffers && g_GlVersion >= 440)
+        use_ring = ImGui_ImplOpenGL3_UploadRing(draw_data, &vtx_base, &idx_base);
+    else if (g_RingActive)
+        ImGui_ImplOpenGL3_DestroyRing();
+#endif
+
     // Setup desired GL state
     // Recreate the VAO every time (this is to easily allow multiple GL contexts to be rendered to. VAO are not shared among GL contexts)
     // The renderer would actually work without any VAO bound, but then our VertexAttrib calls would overwrite the default one currently bound.
@@ -341,8 +467,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
 
         // Upload vertex/index buffers
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+        if (!use_ring)
+        {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+        }
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -374,15 +503,29 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                     glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
 #if IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                     if (g_GlVersion >= 320)
-                        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset);
+                        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)((idx_base + pcmd->IdxOffset) * sizeof(ImDrawIdx)), (GLint)(vtx_base + pcmd->VtxOffset));
                     else
 #endif
                     glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)));
                 }
             }
         }
+        if (use_ring)
+        {
+            vtx_base += cmd_list->VtxBuffer.Size;
+            idx_base += cmd_list->IdxBuffer.Size;
+        }
     }
 
+#if IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    // The region can be written again once the GPU has consumed this frame's draws
+    if (use_ring)
+    {
+        g_RingFences[g_RingFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        g_RingFrame = (g_RingFrame + 1) % IMGUI_IMPL_OPENGL_RING_FRAMES;
+    }
+#endif
+
     // Destroy the temporary VAO
 #ifndef IMGUI_IMPL_OPENGL_ES2
     glDeleteVertexArrays(1, &vertex_array_object);
@@ -670,6 +813,9 @@ bool    ImGui_ImplOpenGL3_CreateDeviceObjects()
 
 void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
 {
+#if IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (g_RingActive)       { ImGui_ImplOpenGL3_DestroyRing(); }
+#endif
     if (g_VboHandle)        { glDeleteBuffers(1, &g_VboHandle); g_VboHandle = 0; }
     if (g_ElementsHandle)   { glDeleteBuffers(1, &g_ElementsHandle); g_ElementsHandle = 0; }
     if (g_ShaderHandle && g_VertHandle) { glDetachShader(g_ShaderHandle, g_VertHandle); }
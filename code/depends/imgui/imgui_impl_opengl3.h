@@ -36,6 +36,10 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 
+// (Optional) Desktop GL 4.4+: upload vertices/indices through a persistently mapped ring buffer (default) or with glBufferData() per command list.
+// Returns true if the ring buffer is used, false if the context or GL loader don't support it.
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_SetPersistentBuffers(bool enable);
+
 // Specific OpenGL ES versions
 //#define IMGUI_IMPL_OPENGL_ES2     // Auto-detected on Emscripten
 //#define IMGUI_IMPL_OPENGL_ES3     // Auto-detected on iOS/Android
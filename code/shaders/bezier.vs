@@ -0,0 +1,16 @@
+#version 330 core
+// One cubic Bezier segment per instance, sampled at samples evenly spaced t from
+// gl_VertexID. The segment runs between two interpolated points, each given as
+// (x, y, tangent x, tangent y) in NDC, with control points a third of the tangent inside.
+layout (location = 0) in vec4 aStart;
+layout (location = 1) in vec4 aEnd;
+uniform int samples; // Vertices per segment, at least 2
+void main()
+{
+       float t = float(gl_VertexID) / float(samples - 1);
+       float s = 1.0 - t;
+       vec2 b0 = aStart.xy, b1 = aStart.xy + aStart.zw / 3.0;
+       vec2 b2 = aEnd.xy - aEnd.zw / 3.0, b3 = aEnd.xy;
+       vec2 p = s * s * s * b0 + 3.0 * s * s * t * b1 + 3.0 * s * t * t * b2 + t * t * t * b3;
+       gl_Position = vec4(p, 0.0, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 400 core
+// One single-vertex patch per segment: pass both end nodes, each given as
+// (x, y, tangent x, tangent y) in NDC, on to bezier.tcs
+layout (location = 0) in vec4 aStart;
+layout (location = 1) in vec4 aEnd;
+out vec4 vStart;
+out vec4 vEnd;
+out float vSegment; // Index of the segment (gl_PrimitiveID restarts when drivers split draws)
+void main()
+{
+       vStart = aStart;
+       vEnd = aEnd;
+       vSegment = float(gl_VertexID);
+}
@@ -1,6 +1,7 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
+layout (location = 0) in vec2 aPos;
+uniform vec4 dequantize; // Stored vertex to NDC: aPos * dequantize.xy + dequantize.zw
 void main()
 {
-       gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+       gl_Position = vec4(aPos * dequantize.xy + dequantize.zw, 0.0, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "cachedir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+std::string userCacheDirectory()
+{
+    if (const char *dir = getenv("CURVE_CACHE_DIR"))
+        return dir;
+#ifdef _WIN32
+    if (const char *dir = getenv("LOCALAPPDATA"))
+        return std::string(dir) + "\\curve-editor";
+#else
+    if (const char *dir = getenv("XDG_CACHE_HOME"))
+        return std::string(dir) + "/curve-editor";
+    if (const char *dir = getenv("HOME"))
+        return std::string(dir) + "/.cache/curve-editor";
+#endif
+    return "";
+}
+
+std::string cacheTemporaryFile(const std::string &filename)
+{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%ld.tmp", (long)getpid());
+    return filename + suffix;
+}
+
+uint64_t cacheHashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Per-user directory for the caches that speed up startup (program binaries, font
+// atlas): $CURVE_CACHE_DIR, else $XDG_CACHE_HOME/curve-editor or ~/.cache/curve-editor
+// (%LOCALAPPDATA%\curve-editor on Windows). Empty if there is no such directory.
+// Not created here.
+std::string userCacheDirectory();
+
+// Name to write filename under before renaming it into place: unique to this process,
+// so that editors starting at the same time never write to the same file
+std::string cacheTemporaryFile(const std::string &filename);
+
+// 64-bit FNV-1a, for the cache keys: start from cacheHashBasis and feed every input
+static const uint64_t cacheHashBasis = 0xcbf29ce484222325ull;
+uint64_t cacheHashBytes(uint64_t hash, const void *data, size_t size);
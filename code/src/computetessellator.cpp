@@ -0,0 +1,142 @@
+#include "computetessellator.h"
+#include <algorithm>
+#include <stdint.h>
+
+static const int workgroupSize = 256;            // local_size_x of bezier.comp
+static const int maxPieces = 1023;               // The CPU's adaptive mode stops at 1024 samples
+static const size_t initialPiecesPerSegment = 8; // First guess at the vertex count, grown on overflow
+
+bool createComputeTessellator(ComputeTessellator &tessellator, GLuint program)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (program == 0 || major * 10 + minor < 43)
+        return false;
+
+    tessellator.program = program;
+    tessellator.stageLocation = glGetUniformLocation(program, "stage");
+    tessellator.segmentsLocation = glGetUniformLocation(program, "segments");
+    tessellator.capacityLocation = glGetUniformLocation(program, "capacity");
+    tessellator.pixelScaleLocation = glGetUniformLocation(program, "pixelScale");
+    tessellator.toleranceLocation = glGetUniformLocation(program, "tolerance");
+    tessellator.maxPiecesLocation = glGetUniformLocation(program, "maxPieces");
+
+    glGenBuffers(1, &tessellator.offsets);
+    glGenBuffers(1, &tessellator.blockOffsets);
+    glGenBuffers(1, &tessellator.command);
+    const GLuint emptyCommand[5] = {0, 0, 0, 0, 0};
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, tessellator.command);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(emptyCommand), emptyCommand, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glGenBuffers(1, &tessellator.VBO);
+    glGenVertexArrays(1, &tessellator.VAO);
+    glBindVertexArray(tessellator.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, tessellator.VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    return true;
+}
+
+void destroyComputeTessellator(ComputeTessellator &tessellator)
+{
+    if (tessellator.fence)
+        glDeleteSync(tessellator.fence);
+    glDeleteBuffers(1, &tessellator.offsets);
+    glDeleteBuffers(1, &tessellator.blockOffsets);
+    glDeleteBuffers(1, &tessellator.command);
+    glDeleteBuffers(1, &tessellator.VBO);
+    glDeleteVertexArrays(1, &tessellator.VAO);
+    tessellator = ComputeTessellator();
+}
+
+// Reallocate VBO to hold vertices (x, y) pairs; the contents are rewritten by the next run anyway
+static void setCapacity(ComputeTessellator &tessellator, size_t vertices)
+{
+    tessellator.capacity = vertices;
+    glBindBuffer(GL_ARRAY_BUFFER, tessellator.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices * 2 * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+}
+
+void runComputeTessellator(ComputeTessellator &tessellator, const DynamicBuffer &nodes,
+                           float pixelScaleX, float pixelScaleY, float tolerance)
+{
+    int segments = std::max(0, (int)(nodes.size / (4 * sizeof(float))) - 1);
+    int blocks = (segments + workgroupSize - 1) / workgroupSize;
+    tessellator.segments = segments;
+    if (segments == 0)
+        return;
+
+    if (segments > tessellator.scratchSegments)
+    {
+        tessellator.scratchSegments = segments;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, tessellator.offsets);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, segments * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, tessellator.blockOffsets);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, blocks * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    if (tessellator.capacity < (size_t)segments + 1)
+        setCapacity(tessellator, std::max(tessellator.capacity, segments * initialPiecesPerSegment + 1));
+
+    glUseProgram(tessellator.program);
+    glUniform1ui(tessellator.segmentsLocation, segments);
+    glUniform1ui(tessellator.capacityLocation, (GLuint)std::min<size_t>(tessellator.capacity, UINT32_MAX));
+    glUniform2f(tessellator.pixelScaleLocation, pixelScaleX, pixelScaleY);
+    glUniform1f(tessellator.toleranceLocation, tolerance);
+    glUniform1ui(tessellator.maxPiecesLocation, maxPieces);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, nodes.VBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, tessellator.offsets);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, tessellator.blockOffsets);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, tessellator.VBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, tessellator.command);
+
+    glUniform1i(tessellator.stageLocation, 0);
+    glDispatchCompute(blocks, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUniform1i(tessellator.stageLocation, 1);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUniform1i(tessellator.stageLocation, 2);
+    glDispatchCompute(blocks, 1, 1);
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+
+    // An unchecked earlier run is superseded by this one, which has at least its capacity
+    if (tessellator.fence)
+        glDeleteSync(tessellator.fence);
+    tessellator.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool computeTessellatorOverflowed(ComputeTessellator &tessellator, bool wait)
+{
+    if (!tessellator.fence)
+        return false;
+    GLenum status = glClientWaitSync(tessellator.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? UINT64_MAX : 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+    glDeleteSync(tessellator.fence);
+    tessellator.fence = 0;
+
+    // The run is complete, so reading its vertex count does not stall
+    GLuint needed = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, tessellator.command);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 4 * sizeof(GLuint), sizeof(needed), &needed);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (needed <= tessellator.capacity)
+        return false;
+    setCapacity(tessellator, needed + needed / 4);
+    return true;
+}
+
+void drawComputeTessellator(const ComputeTessellator &tessellator)
+{
+    if (tessellator.segments == 0)
+        return;
+    glBindVertexArray(tessellator.VAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, tessellator.command);
+    glDrawArraysIndirect(GL_LINE_STRIP, (void *)0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
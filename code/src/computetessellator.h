@@ -0,0 +1,37 @@
+#pragma once
+#include "gpubuffer.h"
+
+// Adaptive tessellation of the whole curve in a compute pass (shaders/bezier.comp,
+// OpenGL 4.3). It reads the nodes buffer of the other GPU paths (bezierNodeVertices),
+// writes the vertices straight into its own VBO and the vertex count into an indirect
+// draw command, so the CPU neither tessellates nor learns how many vertices there are.
+// The vertices match the CPU's adaptive mode: same sample counts, same layout.
+struct ComputeTessellator
+{
+    GLuint program = 0;
+    GLint stageLocation = -1, segmentsLocation = -1, capacityLocation = -1;
+    GLint pixelScaleLocation = -1, toleranceLocation = -1, maxPiecesLocation = -1;
+    GLuint offsets = 0, blockOffsets = 0; // Prefix sum scratch
+    GLuint command = 0;                   // DrawArraysIndirectCommand, then the vertex count needed
+    GLuint VBO = 0, VAO = 0;              // (x, y) float32 vertices in NDC, for vshader.vs
+    size_t capacity = 0;                  // Vertices VBO holds
+    int segments = 0;                     // Segments of the last run
+    int scratchSegments = 0;              // Segments offsets and blockOffsets are sized for
+    GLsync fence = 0;                     // Signaled when the last run finished
+};
+
+// program is bezier.comp, linked. Returns false if the context lacks compute shaders.
+bool createComputeTessellator(ComputeTessellator &tessellator, GLuint program);
+void destroyComputeTessellator(ComputeTessellator &tessellator);
+
+// Tessellate the segments between the nodes in buffer for a viewport of
+// 2 * pixelScaleX by 2 * pixelScaleY pixels, to within tolerance pixels
+void runComputeTessellator(ComputeTessellator &tessellator, const DynamicBuffer &nodes,
+                           float pixelScaleX, float pixelScaleY, float tolerance);
+// True if the last run produced more vertices than fit; the VBO has then been grown
+// and the run should be repeated. Without wait, a run the GPU has not finished yet
+// counts as fitting; check with wait before going idle, or an overflow of the last
+// run stays on screen until the next redraw.
+bool computeTessellatorOverflowed(ComputeTessellator &tessellator, bool wait);
+// glDrawArraysIndirect of the vertices as a line strip; bind vshader.vs with an identity dequantize first
+void drawComputeTessellator(const ComputeTessellator &tessellator);
@@ -0,0 +1,412 @@
+#include "curve.h"
+#include "threadpool.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <string.h>
+
+// Curve state shared with the editor (see curve.h)
+CurveDocument curveDocument;
+std::vector<float> controlPointVertices;
+std::vector<float> controlPolyline;
+std::vector<float> piecewiseBezier;
+std::vector<float> tangentLines;
+std::vector<float> bezierNodeVertices;
+bool showTangents = true;
+int tessellationMode = TESSELLATE_DIRECT;
+int tangentMode = TANGENTS_CENTRAL_DIFFERENCE;
+float curveTolerance = 1.25f;
+float splineDragError = 0.0f;
+float ndcToPixelsX = 320.0f, ndcToPixelsY = 320.0f;
+bool curveRebuildRequested = false;
+bool gpuBezierEvaluation = false;
+curveUpdateTimes lastCurveUpdateTimes = {0.0, 0.0};
+
+// Interpolated points and their tangents, cached between updates so that a
+// drag only re-evaluates the segments around the moved control point.
+std::vector<point2d> bezierNodes;
+std::vector<point2d> bezierTangents;
+std::vector<int> bezierOffsets; // Vertex of the t=0 sample of each segment, plus one entry past the last segment
+BernsteinTable bezierWeights;   // Basis weights for SAMPLES_PER_BEZIER samples
+SplineWorkspace splineWorkspace; // Scratch of the natural spline solver
+bool tangentVisualsShown = false;
+int tessellationModeUsed = TESSELLATE_DIRECT;
+int tangentModeUsed = TANGENTS_CENTRAL_DIFFERENCE;
+bool gpuEvaluationUsed = false;
+
+// Range of control points moved since the last curve update (empty if first > last).
+int dirtyFirst = INT_MAX, dirtyLast = -1;
+
+// Loops shorter than this stay on the calling thread: waking the pool costs a few
+// microseconds, which only pays off on long curves. Interactive drags never reach it.
+static const int parallelCutoff = 16384;
+static const int parallelGrain = 4096;
+
+// Natural spline drags patch the tangents near the moved points only (updateNaturalSpline).
+// Each patch may leave the curve splinePatchTolerance pixels off the full solution, about
+// the float resolution of NDC coordinates; once the patches could add up to
+// splineDragTolerance, the next update solves the whole curve again.
+static const float splineDragTolerance = 0.01f;
+static const float splinePatchTolerance = splineDragTolerance / 1024.0f;
+
+// Call f(i) for every i in [begin, end), spread over the thread pool for long ranges
+template <typename F>
+static void forEachIndex(int begin, int end, F f)
+{
+    if (end - begin < parallelCutoff)
+    {
+        for (int i = begin; i < end; i++)
+            f(i);
+        return;
+    }
+    globalThreadPool().parallelFor(begin, end, parallelGrain, [&](int lo, int hi)
+                                   {
+                                       TRACE_ZONE("curve chunk");
+                                       for (int i = lo; i < hi; i++)
+                                           f(i);
+                                   });
+}
+
+void markControlPointDirty(int index)
+{
+    dirtyFirst = std::min(dirtyFirst, index);
+    dirtyLast = std::max(dirtyLast, index);
+}
+
+void clearDirtyRange()
+{
+    dirtyFirst = INT_MAX;
+    dirtyLast = -1;
+}
+
+// Output vertices are laid out segment after segment, with the first sample of every
+// segment except the first one shared with the previous segment. Sample k of segment i
+// thus always lives at vertex i * (samples - 1) + k, whatever the rest of the curve does.
+void setVertex(std::vector<float> &vertices, int index, float x, float y)
+{
+    vertices[2 * index] = x;
+    vertices[2 * index + 1] = y;
+}
+
+void sampleControlPolylineSegment(int i)
+{
+    int samples = SAMPLES_PER_BEZIER;
+    float delta_t = 1.0 / (samples - 1.0);
+    point2d p0 = curveDocumentNdc(curveDocument, i), p1 = curveDocumentNdc(curveDocument, i + 1);
+    float x[2] = {p0.x, p1.x}, y[2] = {p0.y, p1.y};
+
+    for (int k = (i > 0 ? 1 : 0); k < samples; k++)
+    {
+        float t = k * delta_t;
+        setVertex(controlPolyline, i * (samples - 1) + k, x[0] + t * (x[1] - x[0]), y[0] + t * (y[1] - y[0]));
+    }
+}
+
+void calculateControlPolyline()
+{
+    // Since controlPolyline is just a polyline, we can simply copy the control points and plot.
+    // However to show how a piecewise parametric curve needs to be plotted, we sample t and
+    // evaluate it as a piecewise linear bezier curve.
+    // controlPolyline.assign(controlPoints.begin(), controlPoints.end());
+
+    int npts = curveDocumentSize(curveDocument);
+    if (npts < 2)
+    {
+        controlPolyline.resize(2 * npts);
+        curveDocumentNdcVertices(curveDocument, 0, npts, controlPolyline.data());
+        return;
+    }
+
+    int nsegments = npts - 1;
+    controlPolyline.resize(2 * (nsegments * (SAMPLES_PER_BEZIER - 1) + 1));
+    forEachIndex(0, nsegments, sampleControlPolylineSegment);
+}
+
+// Vertices covered by segments first..last, including the start vertex shared with segment first-1
+vertexRange segmentVertices(int first, int last)
+{
+    int perSegment = std::max(2, SAMPLES_PER_BEZIER) - 1;
+    return {first * perSegment, (last - first + 1) * perSegment + 1};
+}
+
+// Re-sample only the polyline segments adjacent to control points first..last
+vertexRange updateControlPolyline(int first, int last)
+{
+    int nsegments = curveDocumentSize(curveDocument) - 1;
+    int lo = std::max(0, first - 1), hi = std::min(last, nsegments - 1);
+    for (int i = lo; i <= hi; i++)
+        sampleControlPolylineSegment(i);
+    return segmentVertices(lo, hi);
+}
+
+void calculateTangentVisual(int i)
+{
+    const std::vector<point2d> &B = bezierNodes;
+    const std::vector<point2d> &T = bezierTangents;
+
+    point2d handle_in = {B[i].x - T[i].x / 3.0f, B[i].y - T[i].y / 3.0f};
+    point2d handle_out = {B[i].x + T[i].x / 3.0f, B[i].y + T[i].y / 3.0f};
+
+    setVertex(tangentLines, 2 * i, handle_in.x, handle_in.y);
+    setVertex(tangentLines, 2 * i + 1, handle_out.x, handle_out.y);
+}
+
+void calculateTangentVisuals()
+{
+    tangentVisualsShown = showTangents;
+    if (!showTangents)
+    {
+        tangentLines.clear();
+        return;
+    }
+
+    tangentLines.resize(4 * bezierNodes.size());
+    forEachIndex(0, bezierNodes.size(), calculateTangentVisual);
+}
+
+void calculateTangent(int i)
+{
+    const std::vector<point2d> &B = bezierNodes;
+    int n = B.size() - 1;
+
+    if (i == 0) // finite difference at the ends
+        bezierTangents[0] = {B[1].x - B[0].x, B[1].y - B[0].y};
+    else if (i == n)
+        bezierTangents[n] = {B[n].x - B[n - 1].x, B[n].y - B[n - 1].y};
+    else // using central difference
+        bezierTangents[i] = {(B[i + 1].x - B[i - 1].x) * 0.5f,
+                             (B[i + 1].y - B[i - 1].y) * 0.5f};
+}
+
+void setNodeVertex(int i)
+{
+    float *node = &bezierNodeVertices[4 * i];
+    node[0] = bezierNodes[i].x;
+    node[1] = bezierNodes[i].y;
+    node[2] = bezierTangents[i].x;
+    node[3] = bezierTangents[i].y;
+}
+
+void segmentControlPoints(int i, point2d ctrl[4])
+{
+    const std::vector<point2d> &B = bezierNodes;
+    const std::vector<point2d> &T = bezierTangents;
+
+    // Control points B0..B3 for the cubic between B[i] and B[i+1]
+    ctrl[0] = B[i];
+    ctrl[1] = {B[i].x + T[i].x / 3.0f, B[i].y + T[i].y / 3.0f};
+    ctrl[2] = {B[i + 1].x - T[i + 1].x / 3.0f, B[i + 1].y - T[i + 1].y / 3.0f};
+    ctrl[3] = B[i + 1];
+}
+
+int segmentSampleCount(const point2d ctrl[4])
+{
+    if (tessellationModeUsed != TESSELLATE_ADAPTIVE)
+        return bezierWeights.samples;
+    return adaptiveSampleCount(ctrl, ndcToPixelsX, ndcToPixelsY, curveTolerance, 1024);
+}
+
+void sampleBezierSegment(int i)
+{
+    point2d ctrl[4];
+    segmentControlPoints(i, ctrl);
+
+    // Sample [0,1] into this segment's slice of piecewiseBezier (using parametric equation  t from 0 to 1),
+    // with the selected tessellation backend
+    int first = i > 0 ? 1 : 0;
+    float *out = &piecewiseBezier[2 * (bezierOffsets[i] + first)];
+    if (tessellationModeUsed == TESSELLATE_ADAPTIVE)
+        sampleCubicForwardDifference(ctrl, bezierOffsets[i + 1] - bezierOffsets[i] + 1, first, out);
+    else
+        getTessellationSampler((TessellationMode)tessellationModeUsed, bezierWeights.samples)(ctrl, bezierWeights, first, out);
+}
+
+void calculatePiecewiseBezier()
+{
+    // processing control points
+    int m = curveDocumentSize(curveDocument);
+    bezierNodes.resize(m);
+    forEachIndex(0, m, [](int i)
+                 { bezierNodes[i] = curveDocumentNdc(curveDocument, i); });
+
+    gpuEvaluationUsed = gpuBezierEvaluation;
+    if (m < 2) // checking if only one point
+    {
+        piecewiseBezier.clear();
+        tangentLines.clear();
+        bezierNodeVertices.clear();
+        return;
+    }
+    int n = m - 1; // last index
+
+    // calculating tangents points
+    bezierTangents.resize(m);
+    tangentModeUsed = tangentMode;
+    splineDragError = 0.0f;
+    if (tangentModeUsed == TANGENTS_NATURAL_SPLINE)
+        solveNaturalSpline(bezierNodes.data(), m, bezierTangents.data(), splineWorkspace);
+    else
+        forEachIndex(0, m, calculateTangent);
+
+    // Calculate the visuals for the tangents
+    calculateTangentVisuals();
+
+    tessellationModeUsed = tessellationMode;
+    curveRebuildRequested = false;
+
+    // The vertex shader samples the segments from their end nodes; nothing to tessellate here
+    if (gpuEvaluationUsed)
+    {
+        piecewiseBezier.clear();
+        bezierNodeVertices.resize(4 * m);
+        forEachIndex(0, m, setNodeVertex);
+        return;
+    }
+    bezierNodeVertices.clear();
+
+    // Size every segment first so the output can be allocated once, then sample into it
+    int samples = std::max(2, SAMPLES_PER_BEZIER);
+    if (bezierWeights.samples != samples)
+        buildBernsteinTable(bezierWeights, samples);
+
+    bezierOffsets.resize(m);
+    bezierOffsets[0] = 0;
+    forEachIndex(0, n, [](int i)
+                 {
+                     point2d ctrl[4];
+                     segmentControlPoints(i, ctrl);
+                     bezierOffsets[i + 1] = segmentSampleCount(ctrl) - 1;
+                 });
+    for (int i = 0; i < n; ++i)
+        bezierOffsets[i + 1] += bezierOffsets[i];
+
+    piecewiseBezier.resize(2 * (bezierOffsets[n] + 1));
+    forEachIndex(0, n, sampleBezierSegment);
+}
+
+// Patch the curve after control points first..last moved. With central-difference
+// tangents, moving point i changes T[i-1..i+1] and hence only segments i-2..i+1.
+// Natural spline tangents change along the whole curve, but by less than
+// splinePatchTolerance past a few rows on either side: only those are re-solved.
+// If the segments around the changed tangents now need a different number of samples
+// (adaptive mode), the rest of the curve is shifted to make room.
+// The vertices that changed in piecewiseBezier and tangentLines are returned in curve and tangents.
+void updatePiecewiseBezier(int first, int last, vertexRange &curve, vertexRange &tangents)
+{
+    int n = bezierNodes.size() - 1;
+    float moved = 0.0f; // Summed over the moved points, in NDC
+    for (int i = first; i <= last; i++)
+    {
+        point2d node = curveDocumentNdc(curveDocument, i);
+        moved += std::max(std::fabs(node.x - bezierNodes[i].x), std::fabs(node.y - bezierNodes[i].y));
+        bezierNodes[i] = node;
+    }
+
+    int lo = std::max(0, first - 1), hi = std::min(n, last + 1);
+    if (tangentModeUsed == TANGENTS_NATURAL_SPLINE)
+    {
+        // A tangent error e moves the curve by at most e / 4, at the middle of a segment
+        float pixels = std::max(ndcToPixelsX, ndcToPixelsY);
+        SplinePatch patch = updateNaturalSpline(bezierNodes.data(), n + 1, bezierTangents.data(), first, last, moved,
+                                                4.0f * splinePatchTolerance / pixels, splineWorkspace);
+        splineDragError += 0.25f * patch.errorBound * pixels;
+        lo = patch.first;
+        hi = patch.last;
+    }
+    else
+    {
+        for (int i = lo; i <= hi; i++)
+            calculateTangent(i);
+    }
+    if (showTangents)
+    {
+        for (int i = lo; i <= hi; i++)
+            calculateTangentVisual(i);
+    }
+    tangents = {2 * lo, showTangents ? 2 * (hi - lo + 1) : 0};
+
+    if (gpuEvaluationUsed)
+    {
+        for (int i = lo; i <= hi; i++)
+            setNodeVertex(i);
+        curve = {lo, hi - lo + 1};
+        return;
+    }
+
+    // The segments on either side of the changed tangents
+    lo = std::max(0, lo - 1);
+    hi = std::min(n - 1, hi);
+    int oldTotal = piecewiseBezier.size() / 2;
+    int oldEnd = bezierOffsets[hi + 1];
+    for (int i = lo; i <= hi; i++)
+    {
+        point2d ctrl[4];
+        segmentControlPoints(i, ctrl);
+        bezierOffsets[i + 1] = bezierOffsets[i] + segmentSampleCount(ctrl) - 1;
+    }
+
+    int shift = bezierOffsets[hi + 1] - oldEnd;
+    if (shift != 0)
+    {
+        int tail = oldTotal - oldEnd;
+        if (shift > 0)
+            piecewiseBezier.resize(2 * (oldTotal + shift));
+        memmove(&piecewiseBezier[2 * (oldEnd + shift)], &piecewiseBezier[2 * oldEnd], 2 * tail * sizeof(float));
+        if (shift < 0)
+            piecewiseBezier.resize(2 * (oldTotal + shift));
+        for (int i = hi + 2; i <= n; i++)
+            bezierOffsets[i] += shift;
+    }
+
+    for (int i = lo; i <= hi; i++)
+        sampleBezierSegment(i);
+
+    int end = shift != 0 ? piecewiseBezier.size() / 2 - 1 : bezierOffsets[hi + 1];
+    curve = {bezierOffsets[lo], end - bezierOffsets[lo] + 1};
+}
+
+// An in-place patch is only valid while the curve keeps its shape: same number of
+// control points, tangent visibility and tessellation settings as the last full rebuild,
+// and for natural spline tangents, room left for one more patch in splineDragTolerance.
+bool canUpdateIncrementally()
+{
+    return dirtyLast >= 0 && bezierNodes.size() >= 2 && tangentModeUsed == tangentMode &&
+           (tangentModeUsed == TANGENTS_CENTRAL_DIFFERENCE ||
+            splineDragError + splinePatchTolerance <= splineDragTolerance) &&
+           bezierNodes.size() == (size_t)curveDocumentSize(curveDocument) &&
+           controlPointVertices.size() == 2 * bezierNodes.size() &&
+           tangentVisualsShown == showTangents && gpuEvaluationUsed == gpuBezierEvaluation &&
+           tessellationModeUsed == tessellationMode && !curveRebuildRequested;
+}
+
+bool updateCurve(vertexRange &points, vertexRange &polyline, vertexRange &curve, vertexRange &tangents)
+{
+    TRACE_ZONE("updateCurve");
+    typedef std::chrono::steady_clock clock;
+    bool incremental = canUpdateIncrementally();
+    clock::time_point start = clock::now();
+    if (incremental)
+    {
+        points = {dirtyFirst, dirtyLast - dirtyFirst + 1};
+        curveDocumentNdcVertices(curveDocument, points.first, points.count, &controlPointVertices[2 * points.first]);
+        polyline = updateControlPolyline(dirtyFirst, dirtyLast);
+    }
+    else
+    {
+        controlPointVertices.resize(2 * curveDocumentSize(curveDocument));
+        curveDocumentNdcVertices(curveDocument, 0, curveDocumentSize(curveDocument), controlPointVertices.data());
+        calculateControlPolyline();
+    }
+    clock::time_point polylineDone = clock::now();
+    if (incremental)
+        updatePiecewiseBezier(dirtyFirst, dirtyLast, curve, tangents);
+    else
+        calculatePiecewiseBezier();
+    clock::time_point bezierDone = clock::now();
+    lastCurveUpdateTimes.polylineMs = std::chrono::duration<double, std::milli>(polylineDone - start).count();
+    lastCurveUpdateTimes.bezierMs = std::chrono::duration<double, std::milli>(bezierDone - polylineDone).count();
+    clearDirtyRange();
+    return incremental;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "curvedocument.h"
+#include "spline.h"
+#include "tessellate.h"
+#include <vector>
+
+#define SAMPLES_PER_BEZIER 10 // Sample each Bezier curve as N=10 segments and draw as connected lines
+
+// The control points, and the vertex arrays derived from them as (x, y) pairs in NDC
+extern CurveDocument curveDocument;
+extern std::vector<float> controlPointVertices;
+extern std::vector<float> controlPolyline;
+extern std::vector<float> piecewiseBezier;
+extern std::vector<float> tangentLines;
+// (x, y, tangent x, tangent y) per interpolated point, in NDC: all the vertex shader
+// needs to evaluate the segments itself (bezier.vs). Only kept with gpuBezierEvaluation.
+extern std::vector<float> bezierNodeVertices;
+// The interpolated points and their tangents in NDC, as of the last update
+extern std::vector<point2d> bezierNodes;
+extern std::vector<point2d> bezierTangents;
+
+extern bool showTangents;
+extern int tessellationMode;          // One of TessellationMode
+extern int tangentMode;               // One of TangentMode
+extern float curveTolerance;          // Max distance in pixels between the adaptive polyline and the curve
+extern float splineDragError;         // Bound in pixels on how far drags left a natural spline from its full solve
+extern float ndcToPixelsX, ndcToPixelsY; // Half the viewport size, to measure curveTolerance in pixels
+extern bool curveRebuildRequested;    // Set when a setting changed that invalidates the whole curve
+extern bool gpuBezierEvaluation;      // Fill bezierNodeVertices instead of tessellating piecewiseBezier
+
+// Vertices [first, first + count) of an output vector changed by an update
+struct vertexRange
+{
+    int first, count;
+};
+
+void markControlPointDirty(int index);
+void calculateControlPolyline();
+void calculatePiecewiseBezier();
+void calculateTangentVisuals(); // Uses the tangents of the last calculatePiecewiseBezier()
+
+// CPU time spent in each step of the last updateCurve(), for the frame profiler
+struct curveUpdateTimes
+{
+    double polylineMs, bezierMs;
+};
+extern curveUpdateTimes lastCurveUpdateTimes;
+
+// Bring the vertex arrays up to date with curveDocument.
+// Returns true if only the returned vertex ranges changed, or false if everything was rebuilt.
+// With gpuBezierEvaluation, curve counts nodes of bezierNodeVertices (4 floats each) instead.
+bool updateCurve(vertexRange &points, vertexRange &polyline, vertexRange &curve, vertexRange &tangents);
@@ -0,0 +1,36 @@
+#include "curvedocument.h"
+
+void curveDocumentSetWindow(CurveDocument &doc, float width, float height)
+{
+    doc.center = {0.5f * width, 0.5f * height};
+    doc.halfExtent = {0.5f * width, -0.5f * height};
+}
+
+int curveDocumentAdd(CurveDocument &doc, float x, float y)
+{
+    doc.x.push_back(x);
+    doc.y.push_back(y);
+    return curveDocumentSize(doc) - 1;
+}
+
+void curveDocumentMove(CurveDocument &doc, int index, float x, float y)
+{
+    doc.x[index] = x;
+    doc.y[index] = y;
+}
+
+void curveDocumentClear(CurveDocument &doc)
+{
+    doc.x.clear();
+    doc.y.clear();
+}
+
+void curveDocumentNdcVertices(const CurveDocument &doc, int first, int count, float *out)
+{
+    for (int i = first; i < first + count; i++, out += 2)
+    {
+        point2d p = curveDocumentNdc(doc, i);
+        out[0] = p.x;
+        out[1] = p.y;
+    }
+}
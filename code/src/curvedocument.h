@@ -0,0 +1,70 @@
+#pragma once
+#include "tessellate.h"
+#include <new>
+#include <stddef.h>
+#include <vector>
+
+// Allocator that starts every array on its own cache line (and SIMD vector)
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float>> AlignedFloats;
+
+// The control points of a curve, stored once as separate x and y arrays in
+// document space. The editor uses window pixels (y down); the headless tool
+// uses NDC directly. Everything else (NDC positions for the curve math, GPU
+// vertices, picking) is derived from this store.
+struct CurveDocument
+{
+    AlignedFloats x, y;
+    point2d center = {0.0f, 0.0f};     // Document point at the NDC origin
+    point2d halfExtent = {1.0f, 1.0f}; // Document units from the center to the NDC edge; negative flips the axis
+};
+
+// Map window pixels of a width x height window (y down) to NDC
+void curveDocumentSetWindow(CurveDocument &doc, float width, float height);
+
+inline int curveDocumentSize(const CurveDocument &doc)
+{
+    return (int)doc.x.size();
+}
+
+// Returns the index of the new point
+int curveDocumentAdd(CurveDocument &doc, float x, float y);
+void curveDocumentMove(CurveDocument &doc, int index, float x, float y);
+void curveDocumentClear(CurveDocument &doc);
+
+inline point2d curveDocumentNdc(const CurveDocument &doc, int index)
+{
+    return {(doc.x[index] - doc.center.x) / doc.halfExtent.x, (doc.y[index] - doc.center.y) / doc.halfExtent.y};
+}
+
+// NDC (x, y) pairs of points first..first+count-1, e.g. for a vertex buffer
+void curveDocumentNdcVertices(const CurveDocument &doc, int first, int count, float *out);
@@ -0,0 +1,11 @@
+#pragma once
+
+// The files of shaders/, compiled into the executable by cmake/EmbedShaders.cmake
+// so that programs build without reading anything relative to the working directory
+struct EmbeddedShader
+{
+    const char *name;   // File name, e.g. "vshader.vs"
+    const char *source;
+};
+extern const EmbeddedShader embeddedShaders[];
+extern const int embeddedShaderCount;
@@ -0,0 +1,335 @@
+#include "fontcache.h"
+#include "cachedir.h"
+#include "trace.h"
+#include <filesystem>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char fontCacheMagic[8] = {'C', 'R', 'V', 'F', 'O', 'N', 'T', '1'};
+
+// File layout: FontCacheHeader, the custom rects, then per font a FontCacheFont and its
+// glyphs, then the TexWidth * TexHeight alpha texture
+struct FontCacheHeader
+{
+    char magic[8];
+    uint64_t key;
+    uint32_t glyphBytes; // sizeof(ImFontGlyph), which depends on ImWchar
+    int32_t fonts, customRects;
+    int32_t packIdMouseCursors, packIdLines;
+    int32_t texWidth, texHeight;
+    ImVec2 texUvScale, texUvWhitePixel;
+    ImVec4 texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+};
+
+struct FontCacheRect
+{
+    uint16_t width, height, x, y;
+    uint32_t glyphID;
+    float glyphAdvanceX;
+    ImVec2 glyphOffset;
+    int32_t font; // Index in atlas->Fonts, or -1
+};
+
+struct FontCacheFont
+{
+    float fontSize, ascent, descent;
+    int32_t configDataCount, metricsTotalSurface, glyphs;
+    uint32_t fallbackChar, ellipsisChar;
+};
+
+template <typename T>
+static uint64_t hashValue(uint64_t hash, const T &value)
+{
+    return cacheHashBytes(hash, &value, sizeof(value));
+}
+
+static int fontIndex(const ImFontAtlas *atlas, const ImFont *font)
+{
+    return font ? atlas->Fonts.index_from_ptr(atlas->Fonts.find(const_cast<ImFont *>(font))) : -1;
+}
+
+uint64_t fontAtlasCacheKey(const ImFontAtlas *atlas)
+{
+    uint64_t hash = cacheHashBasis;
+    hash = hashValue(hash, IMGUI_VERSION_NUM);
+    hash = hashValue(hash, atlas->Flags);
+    hash = hashValue(hash, atlas->TexDesiredWidth);
+    hash = hashValue(hash, atlas->TexGlyphPadding);
+    for (const ImFontConfig &config : atlas->ConfigData)
+    {
+        hash = cacheHashBytes(hash, config.FontData, config.FontDataSize);
+        hash = hashValue(hash, config.FontNo);
+        hash = hashValue(hash, config.SizePixels);
+        hash = hashValue(hash, config.OversampleH);
+        hash = hashValue(hash, config.OversampleV);
+        hash = hashValue(hash, config.PixelSnapH);
+        hash = hashValue(hash, config.GlyphExtraSpacing);
+        hash = hashValue(hash, config.GlyphOffset);
+        hash = hashValue(hash, config.GlyphMinAdvanceX);
+        hash = hashValue(hash, config.GlyphMaxAdvanceX);
+        hash = hashValue(hash, config.MergeMode);
+        hash = hashValue(hash, config.RasterizerFlags);
+        hash = hashValue(hash, config.RasterizerMultiply);
+        hash = hashValue(hash, config.EllipsisChar);
+        hash = hashValue(hash, fontIndex(atlas, config.DstFont));
+        const ImWchar *ranges = config.GlyphRanges ? config.GlyphRanges : const_cast<ImFontAtlas *>(atlas)->GetGlyphRangesDefault();
+        for (; ranges[0]; ranges += 2)
+            hash = cacheHashBytes(hash, ranges, 2 * sizeof(ImWchar));
+    }
+    for (const ImFontAtlasCustomRect &rect : atlas->CustomRects)
+    {
+        hash = hashValue(hash, rect.Width);
+        hash = hashValue(hash, rect.Height);
+        hash = hashValue(hash, rect.GlyphID);
+        hash = hashValue(hash, rect.GlyphAdvanceX);
+        hash = hashValue(hash, rect.GlyphOffset);
+        hash = hashValue(hash, fontIndex(atlas, rect.Font));
+    }
+    return hash;
+}
+
+// The whole file, mapped read-only where possible
+struct MappedFile
+{
+    const unsigned char *data = NULL;
+    size_t size = 0;
+    std::string copy; // Where it can't be mapped
+};
+
+static bool mapFile(const char *filename, MappedFile &file)
+{
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    file.data = static_cast<const unsigned char *>(data);
+    file.size = (size_t)info.st_size;
+    return true;
+#else
+    FILE *input = fopen(filename, "rb");
+    if (input == NULL)
+        return false;
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), input)) > 0)
+        file.copy.append(buffer, n);
+    fclose(input);
+    file.data = reinterpret_cast<const unsigned char *>(file.copy.data());
+    file.size = file.copy.size();
+    return file.size > 0;
+#endif
+}
+
+static void unmapFile(MappedFile &file)
+{
+#ifndef _WIN32
+    if (file.data)
+        munmap(const_cast<unsigned char *>(file.data), file.size);
+#endif
+    file = MappedFile();
+}
+
+// Bounds-checked reads from the mapped file
+struct FileReader
+{
+    const unsigned char *at, *end;
+    bool read(void *out, size_t size)
+    {
+        if ((size_t)(end - at) < size)
+            return false;
+        memcpy(out, at, size);
+        at += size;
+        return true;
+    }
+    const unsigned char *skip(size_t size)
+    {
+        if ((size_t)(end - at) < size)
+            return NULL;
+        const unsigned char *data = at;
+        at += size;
+        return data;
+    }
+};
+
+bool fontAtlasCacheLoad(ImFontAtlas *atlas, const char *filename, uint64_t key)
+{
+    TRACE_ZONE("fontAtlasCacheLoad");
+    MappedFile file;
+    if (!mapFile(filename, file))
+        return false;
+
+    // Validate everything before touching the atlas
+    FileReader reader = {file.data, file.data + file.size};
+    FontCacheHeader header;
+    bool ok = reader.read(&header, sizeof(header)) && memcmp(header.magic, fontCacheMagic, sizeof(header.magic)) == 0 &&
+              header.key == key && header.glyphBytes == sizeof(ImFontGlyph) &&
+              header.fonts == atlas->Fonts.Size && header.customRects >= 0 && header.texWidth > 0 && header.texHeight > 0;
+    const unsigned char *rects = ok ? reader.skip(header.customRects * sizeof(FontCacheRect)) : NULL;
+    ImVector<FontCacheFont> fonts;
+    ImVector<const unsigned char *> glyphs;
+    for (int i = 0; rects && i < header.fonts; i++)
+    {
+        FontCacheFont font;
+        const unsigned char *fontGlyphs = NULL;
+        if (!reader.read(&font, sizeof(font)) || font.glyphs < 0 ||
+            (fontGlyphs = reader.skip(font.glyphs * sizeof(ImFontGlyph))) == NULL)
+        {
+            rects = NULL;
+            break;
+        }
+        fonts.push_back(font);
+        glyphs.push_back(fontGlyphs);
+    }
+    const unsigned char *pixels = rects ? reader.skip((size_t)header.texWidth * header.texHeight) : NULL;
+    if (pixels == NULL)
+    {
+        unmapFile(file);
+        return false;
+    }
+
+    // What ImFontAtlasBuildWithStbTruetype and ImFontAtlasBuildFinish would leave behind
+    atlas->ClearTexData();
+    atlas->TexWidth = header.texWidth;
+    atlas->TexHeight = header.texHeight;
+    atlas->TexUvScale = header.texUvScale;
+    atlas->TexUvWhitePixel = header.texUvWhitePixel;
+    memcpy(atlas->TexUvLines, header.texUvLines, sizeof(header.texUvLines));
+    atlas->TexPixelsAlpha8 = (unsigned char *)IM_ALLOC((size_t)header.texWidth * header.texHeight);
+    memcpy(atlas->TexPixelsAlpha8, pixels, (size_t)header.texWidth * header.texHeight);
+
+    atlas->CustomRects.resize(header.customRects);
+    for (int i = 0; i < header.customRects; i++)
+    {
+        FontCacheRect rect;
+        memcpy(&rect, rects + i * sizeof(rect), sizeof(rect));
+        ImFontAtlasCustomRect &r = atlas->CustomRects[i];
+        r.Width = rect.width;
+        r.Height = rect.height;
+        r.X = rect.x;
+        r.Y = rect.y;
+        r.GlyphID = rect.glyphID;
+        r.GlyphAdvanceX = rect.glyphAdvanceX;
+        r.GlyphOffset = rect.glyphOffset;
+        r.Font = rect.font >= 0 && rect.font < atlas->Fonts.Size ? atlas->Fonts[rect.font] : NULL;
+    }
+    atlas->PackIdMouseCursors = header.packIdMouseCursors;
+    atlas->PackIdLines = header.packIdLines;
+
+    for (int i = 0; i < atlas->Fonts.Size; i++)
+    {
+        ImFont *font = atlas->Fonts[i];
+        font->ClearOutputData();
+        font->ContainerAtlas = atlas;
+        for (const ImFontConfig &config : atlas->ConfigData)
+        {
+            if (config.DstFont == font && !config.MergeMode)
+            {
+                font->ConfigData = &config;
+                break;
+            }
+        }
+        font->FontSize = fonts[i].fontSize;
+        font->Ascent = fonts[i].ascent;
+        font->Descent = fonts[i].descent;
+        font->ConfigDataCount = (short)fonts[i].configDataCount;
+        font->MetricsTotalSurface = fonts[i].metricsTotalSurface;
+        font->FallbackChar = (ImWchar)fonts[i].fallbackChar;
+        font->EllipsisChar = (ImWchar)fonts[i].ellipsisChar;
+        font->Glyphs.resize(fonts[i].glyphs);
+        memcpy(font->Glyphs.Data, glyphs[i], fonts[i].glyphs * sizeof(ImFontGlyph));
+        font->BuildLookupTable();
+    }
+    unmapFile(file);
+    return true;
+}
+
+bool fontAtlasCacheStore(const ImFontAtlas *atlas, const char *filename, uint64_t key)
+{
+    TRACE_ZONE("fontAtlasCacheStore");
+    if (atlas->TexPixelsAlpha8 == NULL)
+        return false;
+
+    FontCacheHeader header;
+    memset((void *)&header, 0, sizeof(header)); // Zero the padding too, the file is written as is
+    memcpy(header.magic, fontCacheMagic, sizeof(header.magic));
+    header.key = key;
+    header.glyphBytes = sizeof(ImFontGlyph);
+    header.fonts = atlas->Fonts.Size;
+    header.customRects = atlas->CustomRects.Size;
+    header.packIdMouseCursors = atlas->PackIdMouseCursors;
+    header.packIdLines = atlas->PackIdLines;
+    header.texWidth = atlas->TexWidth;
+    header.texHeight = atlas->TexHeight;
+    header.texUvScale = atlas->TexUvScale;
+    header.texUvWhitePixel = atlas->TexUvWhitePixel;
+    memcpy(header.texUvLines, atlas->TexUvLines, sizeof(header.texUvLines));
+
+    // Write a temporary file and rename it, so that a concurrent start never maps half an atlas
+    std::string temporary = cacheTemporaryFile(filename);
+    FILE *output = fopen(temporary.c_str(), "wb");
+    if (output == NULL)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, output) == 1;
+    for (const ImFontAtlasCustomRect &r : atlas->CustomRects)
+    {
+        FontCacheRect rect = {r.Width, r.Height, r.X, r.Y, r.GlyphID, r.GlyphAdvanceX, r.GlyphOffset, fontIndex(atlas, r.Font)};
+        ok = ok && fwrite(&rect, sizeof(rect), 1, output) == 1;
+    }
+    for (const ImFont *f : atlas->Fonts)
+    {
+        FontCacheFont font = {f->FontSize, f->Ascent, f->Descent, f->ConfigDataCount, f->MetricsTotalSurface,
+                              f->Glyphs.Size, f->FallbackChar, f->EllipsisChar};
+        ok = ok && fwrite(&font, sizeof(font), 1, output) == 1;
+        ok = ok && fwrite(f->Glyphs.Data, sizeof(ImFontGlyph), f->Glyphs.Size, output) == (size_t)f->Glyphs.Size;
+    }
+    size_t pixels = (size_t)atlas->TexWidth * atlas->TexHeight;
+    ok = ok && fwrite(atlas->TexPixelsAlpha8, 1, pixels, output) == pixels;
+    ok = fclose(output) == 0 && ok;
+    std::error_code error;
+    if (ok)
+        std::filesystem::rename(temporary, filename, error);
+    if (!ok || error)
+        remove(temporary.c_str());
+    return ok && !error;
+}
+
+bool buildFontAtlasCached(ImFontAtlas *atlas, const char *directory)
+{
+    TRACE_ZONE("buildFontAtlasCached");
+    std::string dir = directory ? directory : userCacheDirectory();
+    if (atlas->ConfigData.empty())
+        atlas->AddFontDefault();
+    if (dir.empty())
+    {
+        atlas->Build();
+        return false;
+    }
+
+    // Building registers the default custom rects, which changes the key: take it first
+    uint64_t key = fontAtlasCacheKey(atlas);
+    char name[40];
+    snprintf(name, sizeof(name), "/font-%016llx.bin", (unsigned long long)key);
+    std::string filename = dir + name;
+    if (fontAtlasCacheLoad(atlas, filename.c_str(), key))
+        return true;
+
+    atlas->Build();
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    fontAtlasCacheStore(atlas, filename.c_str(), key);
+    return false;
+}
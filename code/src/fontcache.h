@@ -0,0 +1,21 @@
+#pragma once
+#include "imgui.h"
+#include <stdint.h>
+
+// Cache of built ImGui font atlases: the alpha texture plus every font's glyphs and
+// metrics, so later starts skip stb_truetype rasterization and rect packing. Entries
+// are keyed by a hash of the ImGui version and of the atlas input: font data, sizes,
+// glyph ranges, every ImFontConfig field that affects the build, atlas flags and
+// custom rects. Files that don't match the key count as misses.
+
+// Build atlas, whose fonts have been added but not built, from the cache in directory
+// (NULL: the per-user cache directory of cachedir.h), or build it with Build() and
+// store it. Returns true if it came from the cache.
+bool buildFontAtlasCached(ImFontAtlas *atlas, const char *directory = NULL);
+
+// Key of an atlas whose fonts have been added but not built
+uint64_t fontAtlasCacheKey(const ImFontAtlas *atlas);
+// Fill atlas from filename if it holds the entry of key; false on a miss
+bool fontAtlasCacheLoad(ImFontAtlas *atlas, const char *filename, uint64_t key);
+// Write built atlas to filename as the entry of key, taken before building
+bool fontAtlasCacheStore(const ImFontAtlas *atlas, const char *filename, uint64_t key);
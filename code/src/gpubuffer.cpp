@@ -0,0 +1,151 @@
+#include "gpubuffer.h"
+#include <algorithm>
+
+static const size_t minBufferCapacity = 4096; // Avoid a string of tiny reallocations while adding the first points
+
+// Point the VAO's position attribute at the VBO in the buffer's format
+static void setVertexLayout(DynamicBuffer &buffer)
+{
+    glBindVertexArray(buffer.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
+    GLsizei stride = (GLsizei)vertexFormatBytes(buffer.format);
+    if (buffer.format == VERTEX_FLOAT16)
+        glVertexAttribPointer(0, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *)0);
+    else if (buffer.format == VERTEX_SNORM16)
+        glVertexAttribPointer(0, 2, GL_SHORT, GL_TRUE, stride, (void *)0);
+    else
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void *)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+void createDynamicBuffer(DynamicBuffer &buffer, VertexFormat format)
+{
+    glGenBuffers(1, &buffer.VBO);
+    glGenVertexArrays(1, &buffer.VAO);
+
+    // The VAO keeps referring to the same buffer name across reallocations,
+    // so the attribute layout only has to be set up once per format.
+    buffer.format = format;
+    setVertexLayout(buffer);
+}
+
+void destroyDynamicBuffer(DynamicBuffer &buffer)
+{
+    glDeleteBuffers(1, &buffer.VBO);
+    glDeleteVertexArrays(1, &buffer.VAO);
+    buffer = DynamicBuffer();
+}
+
+void setDynamicBufferFormat(DynamicBuffer &buffer, VertexFormat format)
+{
+    if (format == buffer.format)
+        return;
+    buffer.format = format;
+    buffer.quantization = VertexQuantization();
+    buffer.capacity = 0; // Forces a full upload, reallocated at the new vertex size
+    buffer.size = 0;
+    setVertexLayout(buffer);
+}
+
+void uploadDynamicBuffer(DynamicBuffer &buffer, const std::vector<float> &data)
+{
+    uploadDynamicBuffer(buffer, data, 0, data.size());
+}
+
+// Upload floats [first, first + count) of data. If data no longer fits, or a
+// snorm16 vertex left the quantization box, all of data is uploaded instead
+// (after growing the buffer geometrically, or re-fitting the box).
+void uploadDynamicBuffer(DynamicBuffer &buffer, const std::vector<float> &data, size_t first, size_t count)
+{
+    size_t vertexBytes = vertexFormatBytes(buffer.format);
+    size_t bytes = data.size() / 2 * vertexBytes;
+    count = std::min(count, data.size() - std::min(first, data.size()));
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
+
+    bool full = false;
+    if (bytes > buffer.capacity)
+    {
+        buffer.capacity = std::max(std::max(bytes, 2 * buffer.capacity), minBufferCapacity);
+        glBufferData(GL_ARRAY_BUFFER, buffer.capacity, nullptr, GL_DYNAMIC_DRAW);
+        full = true;
+    }
+    if (buffer.format == VERTEX_SNORM16 && (full || !quantizationContains(buffer.quantization, data.data() + first, count / 2)))
+    {
+        buffer.quantization = computeQuantization(data.data(), data.size() / 2);
+        full = true;
+    }
+    if (full)
+    {
+        first = 0;
+        count = data.size();
+    }
+    buffer.size = bytes;
+
+    buffer.uploaded = count / 2 * vertexBytes;
+    if (count == 0)
+        return;
+    if (buffer.format == VERTEX_FLOAT32)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(float), count * sizeof(float), &data[first]);
+        return;
+    }
+    if (buffer.staging.size() < count)
+        buffer.staging.resize(std::max(count, 2 * buffer.staging.size()));
+    packVertices(buffer.format, buffer.quantization, &data[first], count / 2, buffer.staging.data());
+    glBufferSubData(GL_ARRAY_BUFFER, first / 2 * vertexBytes, count / 2 * vertexBytes, buffer.staging.data());
+}
+
+void setDequantizeUniform(const DynamicBuffer &buffer, GLint location)
+{
+    const VertexQuantization &q = buffer.quantization;
+    glUniform4f(location, q.scale[0], q.scale[1], q.offset[0], q.offset[1]);
+}
+
+// Attributes 0 and 1 of VAO read consecutive nodes of VBO, advancing once per divisor instances
+static void setNodePairLayout(GLuint VAO, GLuint VBO, GLuint divisor)
+{
+    const GLsizei stride = 4 * sizeof(float);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void *)0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void *)(size_t)stride);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(0, divisor);
+    glVertexAttribDivisor(1, divisor);
+    glBindVertexArray(0);
+}
+
+void setBezierNodeLayout(DynamicBuffer &buffer)
+{
+    setNodePairLayout(buffer.VAO, buffer.VBO, 1);
+}
+
+void drawBezierSegments(const DynamicBuffer &buffer, GLint samplesLocation, int samples, GLenum mode)
+{
+    int segments = (int)(buffer.size / (4 * sizeof(float))) - 1;
+    if (segments < 1)
+        return;
+    glBindVertexArray(buffer.VAO);
+    glUniform1i(samplesLocation, samples);
+    glDrawArraysInstanced(mode, 0, samples, segments);
+}
+
+GLuint createBezierPatchArray(const DynamicBuffer &buffer)
+{
+    GLuint VAO;
+    glGenVertexArrays(1, &VAO);
+    setNodePairLayout(VAO, buffer.VBO, 0);
+    return VAO;
+}
+
+void drawBezierPatches(GLuint patchArray, const DynamicBuffer &buffer)
+{
+    int segments = (int)(buffer.size / (4 * sizeof(float))) - 1;
+    if (segments < 1)
+        return;
+    glBindVertexArray(patchArray);
+    glPatchParameteri(GL_PATCH_VERTICES, 1);
+    glDrawArrays(GL_PATCHES, 0, segments);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "glloader.h"
+#include "vertexformat.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Vertex buffer of (x, y) vertices whose GPU storage only grows. Storage is
+// (re)allocated with glBufferData when the data outgrows it; every other upload
+// writes just the changed byte range with glBufferSubData.
+// Vertices are stored in the buffer's VertexFormat; draws must set the
+// dequantize uniform of vshader.vs from the buffer (setDequantizeUniform).
+struct DynamicBuffer
+{
+    GLuint VBO = 0;
+    GLuint VAO = 0;
+    VertexFormat format = VERTEX_FLOAT32;
+    VertexQuantization quantization; // Box the VERTEX_SNORM16 vertices are normalized against
+    size_t capacity = 0;             // Bytes allocated on the GPU
+    size_t size = 0;                 // Bytes currently in use
+    size_t uploaded = 0;             // Bytes sent by the last upload, for diagnostics
+    std::vector<uint16_t> staging;   // Packed vertices of the compact formats
+};
+
+void createDynamicBuffer(DynamicBuffer &buffer, VertexFormat format = VERTEX_FLOAT32);
+void destroyDynamicBuffer(DynamicBuffer &buffer);
+// Switching formats drops the GPU contents; the next upload sends everything
+void setDynamicBufferFormat(DynamicBuffer &buffer, VertexFormat format);
+// data holds (x, y) pairs; first and count are in floats and must be even
+void uploadDynamicBuffer(DynamicBuffer &buffer, const std::vector<float> &data);
+void uploadDynamicBuffer(DynamicBuffer &buffer, const std::vector<float> &data, size_t first, size_t count);
+void setDequantizeUniform(const DynamicBuffer &buffer, GLint location);
+
+// Lay the buffer out for bezier.vs instead: data is bezierNodeVertices, 4 floats per
+// node, and instance i reads nodes i and i + 1. The buffer must stay VERTEX_FLOAT32.
+void setBezierNodeLayout(DynamicBuffer &buffer);
+// Draw one instance of samples vertices per segment between the nodes in the buffer
+void drawBezierSegments(const DynamicBuffer &buffer, GLint samplesLocation, int samples, GLenum mode = GL_LINE_STRIP);
+
+// A second vertex array over the same nodes for the tessellation shaders (bezierpatch.vs,
+// bezier.tcs, bezier.tes; OpenGL 4.0): one single-vertex patch per segment, again
+// reading nodes i and i + 1. It stays valid when the buffer reallocates.
+GLuint createBezierPatchArray(const DynamicBuffer &buffer);
+void drawBezierPatches(GLuint patchArray, const DynamicBuffer &buffer);
@@ -0,0 +1,54 @@
+#include "headlessgl.h"
+#include "glloader.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+
+static EGLDisplay headlessDisplay = EGL_NO_DISPLAY;
+static EGLContext headlessContext = EGL_NO_CONTEXT;
+
+bool createHeadlessGLContext(int major, int minor)
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay == NULL)
+    {
+        fprintf(stderr, "Headless GL: eglGetPlatformDisplayEXT is not available\n");
+        return false;
+    }
+
+    headlessDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (headlessDisplay == EGL_NO_DISPLAY || !eglInitialize(headlessDisplay, NULL, NULL))
+    {
+        fprintf(stderr, "Headless GL: cannot initialize a surfaceless EGL display\n");
+        return false;
+    }
+
+    const EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    if (!eglBindAPI(EGL_OPENGL_API) ||
+        (headlessContext = eglCreateContext(headlessDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes)) == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(headlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, headlessContext))
+    {
+        fprintf(stderr, "Headless GL: cannot create an OpenGL %d.%d core context (EGL error 0x%x)\n",
+                major, minor, eglGetError());
+        destroyHeadlessGLContext();
+        return false;
+    }
+    return true;
+}
+
+void destroyHeadlessGLContext()
+{
+    if (headlessDisplay == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(headlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (headlessContext != EGL_NO_CONTEXT)
+        eglDestroyContext(headlessDisplay, headlessContext);
+    eglTerminate(headlessDisplay);
+    headlessDisplay = EGL_NO_DISPLAY;
+    headlessContext = EGL_NO_CONTEXT;
+}
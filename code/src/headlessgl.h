@@ -0,0 +1,7 @@
+#pragma once
+
+// Create an offscreen OpenGL core-profile context of at least the given version
+// and make it current, without a window or display server (EGL surfaceless
+// platform, e.g. Mesa llvmpipe). Prints the reason and returns false on failure.
+bool createHeadlessGLContext(int major, int minor);
+void destroyHeadlessGLContext();
@@ -17,195 +17,128 @@
  ******************************************************************************/
 
 #include "utils.h"
+#include "curve.h"
+#include "computetessellator.h"
+#include "gpubuffer.h"
+#include "profiler.h"
+#include "startup.h"
+#include "trace.h"
+#include <string.h>
 
 #define DRAW_PIECEWISE_BEZIER 1 // Use to switch between drawing control polyline and piecewise bezier curves
-#define SAMPLES_PER_BEZIER 10   // Sample each Bezier curve as N=10 segments and draw as connected lines
 
 // GLobal variables
-std::vector<float> controlPoints;
-std::vector<float> controlPolyline;
-std::vector<float> piecewiseBezier;
-std::vector<float> tangentLines;
 int width = 640, height = 640;
 bool controlPointsUpdated = false;
 bool controlPointsFinished = false;
 int selectedControlPoint = -1;
-bool showTangents = true;
+int vertexFormat = VERTEX_FLOAT32; // Storage of the curve VBOs, one of VertexFormat
+int gpuSamples = SAMPLES_PER_BEZIER; // Vertices per segment when bezier.vs evaluates the curve
 
-unsigned int VBO_tangentLines, VAO_tangentLines;
-struct point2d
+// Where the piecewise Bezier curve is sampled. The GPU paths only upload its nodes (bezierNodeVertices).
+enum CurveEvaluation
 {
-    float x, y;
+    EVALUATE_CPU,                 // Tessellated into piecewiseBezier
+    EVALUATE_VERTEX_SHADER,       // bezier.vs, gpuSamples vertices per segment
+    EVALUATE_TESSELLATION_SHADER, // bezier.tcs/.tes, samples picked per segment from its size on screen
+    EVALUATE_COMPUTE_SHADER,      // bezier.comp, the CPU's adaptive tessellation written straight into a VBO
 };
-
-void calculateControlPolyline()
-{
-    // Since controlPolyline is just a polyline, we can simply copy the control points and plot.
-    // However to show how a piecewise parametric curve needs to be plotted, we sample t and
-    // evaluate it as a piecewise linear bezier curve.
-    // controlPolyline.assign(controlPoints.begin(), controlPoints.end());
-
-    controlPolyline.clear();
-    int sz = controlPoints.size(); // Contains 3 points/vertex. Ignore Z
-    float x[2], y[2];
-    float delta_t = 1.0 / (SAMPLES_PER_BEZIER - 1.0);
-    float t;
-    for (int i = 0; i < (sz - 3); i += 3)
-    {
-        x[0] = controlPoints[i];
-        y[0] = controlPoints[i + 1];
-        x[1] = controlPoints[i + 3];
-        y[1] = controlPoints[i + 4];
-        controlPolyline.push_back(x[0]);
-        controlPolyline.push_back(y[0]);
-        controlPolyline.push_back(0.0);
-
-                t = 0.0;
-        for (float j = 1; j < (SAMPLES_PER_BEZIER - 1); j++)
-        {
-            t += delta_t;
-            controlPolyline.push_back(x[0] + t * (x[1] - x[0]));
-            controlPolyline.push_back(y[0] + t * (y[1] - y[0]));
-            controlPolyline.push_back(0.0);
-        }
-        // No need to add the last point for this segment, since it will be added as first point in next.
-    }
-    // However, add last point of the polyline here (i.e, the last control point)
-    controlPolyline.push_back(x[1]);
-    controlPolyline.push_back(y[1]);
-    controlPolyline.push_back(0.0);
-}
-
-void addPointAs3D(std::vector<float> &bezier, float x, float y)
-{
-
-    bezier.push_back(x);
-    bezier.push_back(y);
-    bezier.push_back(0.0f);
-}
-
-void calculateTangentVisuals(const std::vector<point2d> &B, const std::vector<point2d> &T)
-{
-    tangentLines.clear();
-    if (!showTangents)
-        return;
-
-    for (size_t i = 0; i < B.size(); ++i)
-    {
-
-        point2d handle_in = {B[i].x - T[i].x / 3.0f, B[i].y - T[i].y / 3.0f};
-        point2d handle_out = {B[i].x + T[i].x / 3.0f, B[i].y + T[i].y / 3.0f};
-
-        addPointAs3D(tangentLines, handle_in.x, handle_in.y);
-        addPointAs3D(tangentLines, handle_out.x, handle_out.y);
-    }
-}
-void calculatePiecewiseBezier()
+int curveEvaluation = EVALUATE_CPU;
+bool showProfiler = true;
+bool idleRendering = true;   // Block in glfwWaitEventsTimeout instead of redrawing every vsync
+bool persistentImGuiBuffers = true; // ImGui uploads through a persistently mapped ring buffer (GL 4.4+)
+int redrawFramesPending = 0; // Frames still to draw after the last input event
+bool overlapStartup = true;  // Font atlas on a worker, programs built while ImGui starts (--serial-startup: don't)
+bool startupReport = false;  // --startup-report: print the startup phases after the first frame and exit
+
+int main(int argc, char *argv[])
 {
-    // TODO
-
-    // processing control points
-    piecewiseBezier.clear();
-
-    int m = (controlPoints.size());
-    if (m < 2 * 3) // checking if <=2 vertices
-        return;
-
-    std::vector<point2d> B; // vector holding Bezier curve control points
-    B.reserve(m / 3);       // using reserve to allocate capacity
-    for (int i = 0; i + 2 < m; i += 3)
+    startupBegin();
+    TRACE_THREAD_NAME("main");
+    for (int i = 1; i < argc; i++)
     {
-        B.push_back({controlPoints[i], controlPoints[i + 1]});
+        if (strcmp(argv[i], "--startup-report") == 0)
+            startupReport = true;
+        else if (strcmp(argv[i], "--serial-startup") == 0)
+            overlapStartup = false;
     }
-    int n = (B.size()) - 1; // last index
-    if (n <= 0)             // checking if only one point
-        return;
-    std::vector<point2d> T(B.size());
-
-    // calculating tangents points
-    if (B.size() == 2) // if only 2 segments
-    {
-        T[0] = {B[1].x - B[0].x, B[1].y - B[0].y}; // finite difference
-        T[1] = {B[1].x - B[0].x, B[1].y - B[0].y};
-    }
-    else
-    {
-        T[0] = {B[1].x - B[0].x, B[1].y - B[0].y};
-        T[n] = {B[n].x - B[n - 1].x, B[n].y - B[n - 1].y};
-        for (int i = 1; i < n; i++)
-        {
-            T[i] = {(B[i + 1].x - B[i - 1].x) * 0.5f, // using central difference
-                    (B[i + 1].y - B[i - 1].y) * 0.5f};
-        }
-    }
-
-    // Calculate the visuals for the tangents
-    calculateTangentVisuals(B, T);
-    // For each segment, build cubic Bezier and sample
-    int samples = std::max(2, SAMPLES_PER_BEZIER);
-    float interval = 1.0f / (samples - 1);
-    for (int i = 0; i < n; ++i)
-    {
-        // Control points B0..B3 for the cubic between B[i] and B[i+1]
-        point2d B0 = B[i];
-        point2d B3 = B[i + 1];
-        point2d B1 = {B[i].x + T[i].x / 3.0f, B[i].y + T[i].y / 3.0f};
-        point2d B2 = {B[i + 1].x - T[i + 1].x / 3.0f, B[i + 1].y - T[i + 1].y / 3.0f};
-
-        // Sample [0,1] and append to piecewiseBezier (using parametric equation  t from 0 to 1)
-        for (int k = 0; k < samples; ++k)
-        {
-            float t = k * interval;
-            float v = 1.0f - t;
-            float b0 = v * v * v;
-            float b1 = 3.0f * v * v * t;
-            float b2 = 3.0f * v * t * t;
-            float b3 = t * t * t;
-
-            float x = b0 * B0.x + b1 * B1.x + b2 * B2.x + b3 * B3.x;
-            float y = b0 * B0.y + b1 * B1.y + b2 * B2.y + b3 * B3.y;
-
-            if (i > 0 && k == 0)
-                continue;
-
-            addPointAs3D(piecewiseBezier, x, y);
-        }
-    }
-}
-int main(int, char *argv[])
-{
     GLFWwindow *window = setupWindow(width, height);
     ImGuiIO &io = ImGui::GetIO(); // Create IO object
+    bool persistentImGuiBuffersAvailable = ImGui_ImplOpenGL3_SetPersistentBuffers(persistentImGuiBuffers);
 
     ImVec4 clear_color = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
-
-    unsigned int shaderProgram = createProgram("./shaders/vshader.vs", "./shaders/fshader.fs");
-    glUseProgram(shaderProgram);
+    ndcToPixelsX = 0.5f * width; // Adaptive tessellation tolerance is given in pixels
+    ndcToPixelsY = 0.5f * height;
+    curveDocumentSetWindow(curveDocument, width, height); // Control points are kept in window pixels
 
     // Create VBOs, VAOs
-    unsigned int VBO_controlPoints, VBO_controlPolyline, VBO_piecewiseBezier;
-    unsigned int VAO_controlPoints, VAO_controlPolyline, VAO_piecewiseBezier;
-    glGenBuffers(1, &VBO_controlPoints);
-    glGenVertexArrays(1, &VAO_controlPoints);
-    glGenBuffers(1, &VBO_controlPolyline);
-    glGenVertexArrays(1, &VAO_controlPolyline);
-    // TODO:
-    glGenBuffers(1, &VBO_piecewiseBezier);
-    glGenVertexArrays(1, &VAO_piecewiseBezier);
-
-    glGenBuffers(1, &VBO_tangentLines);
-    glGenVertexArrays(1, &VAO_tangentLines);
-    int button_status = 0;
+    double phase = startupElapsedMs();
+    DynamicBuffer controlPointsBuffer, controlPolylineBuffer, piecewiseBezierBuffer, tangentLinesBuffer, bezierNodesBuffer;
+    createDynamicBuffer(controlPointsBuffer);
+    createDynamicBuffer(controlPolylineBuffer);
+    createDynamicBuffer(piecewiseBezierBuffer);
+    createDynamicBuffer(tangentLinesBuffer);
+    createDynamicBuffer(bezierNodesBuffer);
+    setBezierNodeLayout(bezierNodesBuffer);
+    GLuint bezierPatchArray = createBezierPatchArray(bezierNodesBuffer);
+    startupRecord("buffers", phase);
+
+    GLuint programs[EDITOR_PROGRAM_COUNT];
+    finishStartupPrograms(programs);
+    unsigned int shaderProgram = programs[PROGRAM_CURVE];
+    glUseProgram(shaderProgram);
+    GLint dequantizeLocation = glGetUniformLocation(shaderProgram, "dequantize");
+    unsigned int bezierProgram = programs[PROGRAM_BEZIER_VERTEX];
+    GLint samplesLocation = glGetUniformLocation(bezierProgram, "samples");
+    unsigned int tessellationProgram = programs[PROGRAM_BEZIER_TESSELLATION]; // 0 before OpenGL 4.0
+    GLint pixelScaleLocation = glGetUniformLocation(tessellationProgram, "pixelScale");
+    GLint toleranceLocation = glGetUniformLocation(tessellationProgram, "tolerance");
+    ComputeTessellator computeTessellator;
+    bool computeAvailable = createComputeTessellator(computeTessellator, programs[PROGRAM_BEZIER_COMPUTE]);
+    profilerInit();
+
+    const double idleTimeout = 0.5; // Seconds; wake up periodically even without events
+    const int refreshRate = displayRefreshRate();
+    long long framesRendered = 0;
+    double idleSeconds = 0.0; // Spent blocked in glfwWaitEventsTimeout
+    double firstFrameStart = startupElapsedMs();
 
     // Display loop
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        // About to go idle: wait for the last compute run, whose overflow would otherwise
+        // only be noticed after the next input, and redraw at once if it outgrew the VBO
+        if (idleRendering && redrawFramesPending == 0 && !controlPointsUpdated &&
+            computeTessellatorOverflowed(computeTessellator, true))
+            requestRedraw();
+        if (idleRendering && redrawFramesPending == 0 && !controlPointsUpdated)
+        {
+            // Nothing to show: sleep until input arrives, adding up the time we did not draw
+            TRACE_ZONE("wait for events");
+            double idleStart = glfwGetTime();
+            glfwWaitEventsTimeout(idleTimeout);
+            idleSeconds += glfwGetTime() - idleStart;
+            if (redrawFramesPending == 0)
+                continue;
+        }
+        else
+        {
+            glfwPollEvents();
+        }
+        if (redrawFramesPending > 0)
+            redrawFramesPending--;
+        TRACE_ZONE("frame");
+        profilerBeginFrame();
 
         // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        profilerBeginStage(PROFILE_IMGUI_NEWFRAME);
+        {
+            TRACE_ZONE("ImGui::NewFrame");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+        }
+        profilerEndStage(PROFILE_IMGUI_NEWFRAME);
 
         ImGui::Begin("Options");
         ImGui::Checkbox("Show Tangents", &showTangents);
@@ -213,10 +146,79 @@ int main(int, char *argv[])
         {
             controlPointsUpdated = true; // Redraw when toggled
         }
+        const char *modes[] = {tessellationModeName(TESSELLATE_DIRECT), tessellationModeName(TESSELLATE_FORWARD_DIFFERENCE),
+                               tessellationModeName(TESSELLATE_ADAPTIVE)};
+        if (ImGui::Combo("Tessellation", &tessellationMode, modes, IM_ARRAYSIZE(modes)))
+        {
+            controlPointsUpdated = true; // Rebuild the curve with the new backend
+        }
+        if ((tessellationMode == TESSELLATE_ADAPTIVE || curveEvaluation >= EVALUATE_TESSELLATION_SHADER) &&
+            ImGui::SliderFloat("Tolerance (px)", &curveTolerance, 0.1f, 10.0f, "%.2f"))
+        {
+            // Only the CPU tessellates to the tolerance; the GPU paths read it as a uniform
+            if (curveEvaluation == EVALUATE_CPU && tessellationMode == TESSELLATE_ADAPTIVE)
+            {
+                curveRebuildRequested = true;
+                controlPointsUpdated = true;
+            }
+            else
+                requestRedraw();
+        }
+        const char *tangentModes[] = {tangentModeName(TANGENTS_CENTRAL_DIFFERENCE), tangentModeName(TANGENTS_NATURAL_SPLINE)};
+        if (ImGui::Combo("Tangents", &tangentMode, tangentModes, IM_ARRAYSIZE(tangentModes)))
+        {
+            controlPointsUpdated = true; // Rebuild every tangent
+        }
+        if (tangentMode == TANGENTS_NATURAL_SPLINE)
+            ImGui::Text("Spline drag error: < %.2g px", splineDragError);
+        const char *formats[] = {vertexFormatName(VERTEX_FLOAT32), vertexFormatName(VERTEX_FLOAT16),
+                                 vertexFormatName(VERTEX_SNORM16)};
+        if (ImGui::Combo("Vertex format", &vertexFormat, formats, IM_ARRAYSIZE(formats)))
+        {
+            setDynamicBufferFormat(controlPointsBuffer, (VertexFormat)vertexFormat);
+            setDynamicBufferFormat(controlPolylineBuffer, (VertexFormat)vertexFormat);
+            setDynamicBufferFormat(piecewiseBezierBuffer, (VertexFormat)vertexFormat);
+            setDynamicBufferFormat(tangentLinesBuffer, (VertexFormat)vertexFormat);
+            controlPointsUpdated = true; // Re-upload everything in the new format
+        }
+        const char *evaluations[] = {"CPU tessellation", "Vertex shader", "Tessellation shader", "Compute shader"};
+        if (ImGui::Combo("Curve evaluation", &curveEvaluation, evaluations, computeAvailable ? 4 : tessellationProgram ? 3 : 2))
+        {
+            gpuBezierEvaluation = curveEvaluation != EVALUATE_CPU;
+            controlPointsUpdated = true; // Switch between uploading vertices and uploading nodes
+        }
+        if (curveEvaluation == EVALUATE_VERTEX_SHADER)
+            ImGui::SliderInt("GPU samples", &gpuSamples, 2, 128); // Only a uniform: no curve update needed
+        size_t bufferBytes = controlPointsBuffer.size + controlPolylineBuffer.size + piecewiseBezierBuffer.size +
+                             tangentLinesBuffer.size + bezierNodesBuffer.size;
+        int segments = std::max(0, (int)(bezierNodeVertices.size() / 4) - 1);
+        if (curveEvaluation >= EVALUATE_TESSELLATION_SHADER)
+            ImGui::Text("Curve segments: %d, sampled on the GPU (%zu KiB in VBOs)", segments, bufferBytes / 1024);
+        else
+            ImGui::Text("Curve vertices: %d (%zu KiB in VBOs)",
+                        curveEvaluation == EVALUATE_VERTEX_SHADER ? segments * gpuSamples : (int)(piecewiseBezier.size() / 2),
+                        bufferBytes / 1024);
+        ImGui::Checkbox("Idle when unchanged", &idleRendering);
+        ImGui::Checkbox("Show profiler", &showProfiler);
+        if (persistentImGuiBuffersAvailable && ImGui::Checkbox("Persistent ImGui buffers", &persistentImGuiBuffers))
+            ImGui_ImplOpenGL3_SetPersistentBuffers(persistentImGuiBuffers);
+#if CURVE_TRACE
+        if (ImGui::Button("Save trace"))
+            TRACE_WRITE_JSON("curve_trace.json");
+#endif
+        ImGui::Text("Frames rendered: %lld, idle: %.1f s (~%.0f frames at %d Hz, estimated)", framesRendered, idleSeconds,
+                    idleSeconds * refreshRate, refreshRate);
         ImGui::End();
         // Rendering
-        showOptionsDialog(controlPoints, io);
-        ImGui::Render();
+        showOptionsDialog(curveDocument, io);
+        if (showProfiler)
+            showProfilerWindow();
+        profilerBeginStage(PROFILE_IMGUI_RENDER);
+        {
+            TRACE_ZONE("ImGui::Render");
+            ImGui::Render();
+        }
+        profilerEndStage(PROFILE_IMGUI_RENDER);
 
         // Add a new point on mouse click
         float x, y;
@@ -234,7 +236,7 @@ int main(int, char *argv[])
                 y = io.MousePos.y;
                 if (!controlPointsFinished)
                 { // Add points
-                    addControlPoint(controlPoints, x, y, width, height);
+                    addControlPoint(curveDocument, x, y, width, height);
                     controlPointsUpdated = true;
                 }
                 else
@@ -249,7 +251,7 @@ int main(int, char *argv[])
                 {
                     x = io.MousePos.x;
                     y = io.MousePos.y;
-                    editControlPoint(controlPoints, x, y, width, height);
+                    editControlPoint(curveDocument, x, y);
                     controlPointsUpdated = true;
                 }
             }
@@ -262,81 +264,139 @@ int main(int, char *argv[])
 
         if (controlPointsUpdated)
         {
-            // Update VAO/VBO for control points
-            glBindVertexArray(VAO_controlPoints);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_controlPoints);
-            glBufferData(GL_ARRAY_BUFFER, controlPoints.size() * sizeof(GLfloat), &controlPoints[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-            glEnableVertexAttribArray(0); // Enable first attribute buffer (vertices)
-
-            // Update VAO/VBO for the control polyline
-            calculateControlPolyline();
-            glBindVertexArray(VAO_controlPolyline);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_controlPolyline);
-            glBufferData(GL_ARRAY_BUFFER, controlPolyline.size() * sizeof(GLfloat), &controlPolyline[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-            glEnableVertexAttribArray(0); // Enable first attribute buffer (vertices)
-
-            // Update VAO/VBO for piecewise Bezier curve
-            // TODO:
-            calculatePiecewiseBezier();
-            glBindVertexArray(VAO_piecewiseBezier);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_piecewiseBezier);
-            glBufferData(GL_ARRAY_BUFFER,
-                         piecewiseBezier.size() * sizeof(GLfloat),
-                         piecewiseBezier.empty() ? nullptr : &piecewiseBezier[0],
-                         GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-            glEnableVertexAttribArray(0);
-
-            glBindVertexArray(VAO_tangentLines);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_tangentLines);
-            glBufferData(GL_ARRAY_BUFFER, tangentLines.size() * sizeof(GLfloat), tangentLines.empty() ? nullptr : &tangentLines[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-            glEnableVertexAttribArray(0);
+            // Re-tessellate and re-upload only the segments touched since the last update when possible
+            vertexRange points, polyline, curve, tangents;
+            bool incremental = updateCurve(points, polyline, curve, tangents);
+            profilerAddCpuTime(PROFILE_CONTROL_POLYLINE, lastCurveUpdateTimes.polylineMs);
+            profilerAddCpuTime(PROFILE_PIECEWISE_BEZIER, lastCurveUpdateTimes.bezierMs);
+            profilerBeginStage(PROFILE_UPLOAD, true);
+            TRACE_ZONE("upload");
+            if (incremental)
+            {
+                uploadDynamicBuffer(controlPointsBuffer, controlPointVertices, 2 * points.first, 2 * points.count);
+                uploadDynamicBuffer(controlPolylineBuffer, controlPolyline, 2 * polyline.first, 2 * polyline.count);
+                if (gpuBezierEvaluation)
+                    uploadDynamicBuffer(bezierNodesBuffer, bezierNodeVertices, 4 * curve.first, 4 * curve.count);
+                else
+                    uploadDynamicBuffer(piecewiseBezierBuffer, piecewiseBezier, 2 * curve.first, 2 * curve.count);
+                uploadDynamicBuffer(tangentLinesBuffer, tangentLines, 2 * tangents.first, 2 * tangents.count);
+            }
+            else
+            {
+                uploadDynamicBuffer(controlPointsBuffer, controlPointVertices);
+                uploadDynamicBuffer(controlPolylineBuffer, controlPolyline);
+                uploadDynamicBuffer(piecewiseBezierBuffer, piecewiseBezier);
+                uploadDynamicBuffer(bezierNodesBuffer, bezierNodeVertices);
+                uploadDynamicBuffer(tangentLinesBuffer, tangentLines);
+            }
+            profilerEndStage(PROFILE_UPLOAD);
             controlPointsUpdated = false; // Finish all VAO/VBO updates before setting this to false.
         }
 
+        profilerBeginStage(PROFILE_CURVE_DRAW, true);
         glUseProgram(shaderProgram);
 
         // Draw control points
-        glBindVertexArray(VAO_controlPoints);
-        glDrawArrays(GL_POINTS, 0, controlPoints.size() / 3); // Draw points
+        glBindVertexArray(controlPointsBuffer.VAO);
+        setDequantizeUniform(controlPointsBuffer, dequantizeLocation);
+        glDrawArrays(GL_POINTS, 0, controlPointVertices.size() / 2); // Draw points
 
 #if DRAW_PIECEWISE_BEZIER
         // TODO:
-        glBindVertexArray(VAO_piecewiseBezier);
-        glDrawArrays(GL_LINE_STRIP, 0, piecewiseBezier.size() / 3);
+        if (curveEvaluation == EVALUATE_VERTEX_SHADER)
+        {
+            glUseProgram(bezierProgram);
+            drawBezierSegments(bezierNodesBuffer, samplesLocation, gpuSamples);
+            glUseProgram(shaderProgram);
+        }
+        else if (curveEvaluation == EVALUATE_TESSELLATION_SHADER)
+        {
+            // Measured in framebuffer pixels, so resizing the window changes the level of detail
+            glUseProgram(tessellationProgram);
+            glUniform2f(pixelScaleLocation, 0.5f * display_w, 0.5f * display_h);
+            glUniform1f(toleranceLocation, curveTolerance);
+            drawBezierPatches(bezierPatchArray, bezierNodesBuffer);
+            glUseProgram(shaderProgram);
+        }
+        else if (curveEvaluation == EVALUATE_COMPUTE_SHADER)
+        {
+            // Rerun on every drawn frame, so the level of detail follows the framebuffer size.
+            // A run that outgrew the VBO is noticed a frame later without waiting for the GPU,
+            // or by the blocking check before the loop goes idle.
+            if (computeTessellatorOverflowed(computeTessellator, false))
+                requestRedraw();
+            runComputeTessellator(computeTessellator, bezierNodesBuffer, 0.5f * display_w, 0.5f * display_h, curveTolerance);
+            glUseProgram(shaderProgram);
+            glUniform4f(dequantizeLocation, 1.0f, 1.0f, 0.0f, 0.0f);
+            drawComputeTessellator(computeTessellator);
+        }
+        else
+        {
+            glBindVertexArray(piecewiseBezierBuffer.VAO);
+            setDequantizeUniform(piecewiseBezierBuffer, dequantizeLocation);
+            glDrawArrays(GL_LINE_STRIP, 0, piecewiseBezier.size() / 2);
+        }
 #else
         // Draw control polyline
-        glBindVertexArray(VAO_controlPolyline);
-        glDrawArrays(GL_LINE_STRIP, 0, controlPolyline.size() / 3); // Draw lines
+        glBindVertexArray(controlPolylineBuffer.VAO);
+        setDequantizeUniform(controlPolylineBuffer, dequantizeLocation);
+        glDrawArrays(GL_LINE_STRIP, 0, controlPolyline.size() / 2); // Draw lines
 #endif
         if (showTangents)
         {
-            glBindVertexArray(VAO_tangentLines);
-            glDrawArrays(GL_LINES, 0, tangentLines.size() / 3);
+            glBindVertexArray(tangentLinesBuffer.VAO);
+            setDequantizeUniform(tangentLinesBuffer, dequantizeLocation);
+            glDrawArrays(GL_LINES, 0, tangentLines.size() / 2);
         }
 
         // Draw control points on top
-        glBindVertexArray(VAO_controlPoints);
-        glDrawArrays(GL_POINTS, 0, controlPoints.size() / 3);
+        glBindVertexArray(controlPointsBuffer.VAO);
+        setDequantizeUniform(controlPointsBuffer, dequantizeLocation);
+        glDrawArrays(GL_POINTS, 0, controlPointVertices.size() / 2);
         glUseProgram(0);
+        profilerEndStage(PROFILE_CURVE_DRAW);
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
+        profilerBeginStage(PROFILE_IMGUI_DRAW, true);
+        {
+            TRACE_ZONE("ImGui_ImplOpenGL3_RenderDrawData");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        profilerEndStage(PROFILE_IMGUI_DRAW);
+        profilerEndFrame(); // Before the swap, so the frame time excludes waiting for vsync
+        {
+            TRACE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        if (framesRendered++ == 0)
+        {
+            startupRecord("first frame", firstFrameStart);
+            if (startupReport)
+            {
+                startupPrintReport(stdout);
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+            }
+        }
+
+        // Keep drawing while ImGui is mid-interaction (held buttons, active widgets, typing)
+        if (ImGui::IsAnyItemActive() || ImGui::IsAnyMouseDown() || io.WantTextInput)
+            requestRedraw();
     }
+    std::cout << "Frames rendered: " << framesRendered << ", idle: " << idleSeconds << " s (~"
+              << (long long)(idleSeconds * refreshRate + 0.5) << " frames at " << refreshRate << " Hz, estimated)"
+              << std::endl;
+#if CURVE_TRACE
+    TRACE_WRITE_JSON("curve_trace.json");
+#endif
 
-    // Delete VBO buffers
-    glDeleteBuffers(1, &VBO_controlPoints);
-    glDeleteBuffers(1, &VBO_controlPolyline);
-    glDeleteBuffers(1, &VBO_piecewiseBezier);
-    glDeleteBuffers(1, &VBO_tangentLines);
-    // Delete VAOs
-    glDeleteVertexArrays(1, &VAO_controlPoints);
-    glDeleteVertexArrays(1, &VAO_controlPolyline);
-    glDeleteVertexArrays(1, &VAO_piecewiseBezier);
-    glDeleteVertexArrays(1, &VAO_tangentLines);
+    profilerShutdown();
+    // Delete VBO buffers and VAOs
+    destroyDynamicBuffer(controlPointsBuffer);
+    destroyDynamicBuffer(controlPolylineBuffer);
+    destroyDynamicBuffer(piecewiseBezierBuffer);
+    destroyDynamicBuffer(tangentLinesBuffer);
+    glDeleteVertexArrays(1, &bezierPatchArray);
+    destroyComputeTessellator(computeTessellator);
+    destroyDynamicBuffer(bezierNodesBuffer);
     // Cleanup
     cleanup(window);
     return 0;
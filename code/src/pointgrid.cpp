@@ -0,0 +1,104 @@
+#include "pointgrid.h"
+#include <algorithm>
+#include <cmath>
+
+static int cellCoord(float v, float cellSize, int cells)
+{
+    float c = std::floor(v / cellSize);
+    if (!(c > 0.0f)) // Also maps NaN to the first cell
+        return 0;
+    return c < (float)(cells - 1) ? (int)c : cells - 1;
+}
+
+static int cellIndex(const PointGrid &grid, float x, float y)
+{
+    return cellCoord(y, grid.cellSize, grid.rows) * grid.cols + cellCoord(x, grid.cellSize, grid.cols);
+}
+
+static void linkPoint(PointGrid &grid, int index, int cell)
+{
+    grid.cellOf[index] = cell;
+    grid.prev[index] = -1;
+    grid.next[index] = grid.head[cell];
+    if (grid.head[cell] >= 0)
+        grid.prev[grid.head[cell]] = index;
+    grid.head[cell] = index;
+}
+
+static void unlinkPoint(PointGrid &grid, int index)
+{
+    int p = grid.prev[index], n = grid.next[index];
+    if (p >= 0)
+        grid.next[p] = n;
+    else
+        grid.head[grid.cellOf[index]] = n;
+    if (n >= 0)
+        grid.prev[n] = p;
+}
+
+void pointGridInit(PointGrid &grid, float cellSize, float width, float height)
+{
+    grid.cellSize = cellSize;
+    grid.cols = std::max(1, (int)std::ceil(width / cellSize));
+    grid.rows = std::max(1, (int)std::ceil(height / cellSize));
+    grid.head.assign((size_t)grid.cols * grid.rows, -1);
+    grid.next.clear();
+    grid.prev.clear();
+    grid.cellOf.clear();
+}
+
+void pointGridClear(PointGrid &grid)
+{
+    std::fill(grid.head.begin(), grid.head.end(), -1);
+    grid.next.clear();
+    grid.prev.clear();
+    grid.cellOf.clear();
+}
+
+void pointGridInsert(PointGrid &grid, int index, float x, float y)
+{
+    if (index >= (int)grid.cellOf.size())
+    {
+        grid.next.resize(index + 1, -1);
+        grid.prev.resize(index + 1, -1);
+        grid.cellOf.resize(index + 1, -1);
+    }
+    linkPoint(grid, index, cellIndex(grid, x, y));
+}
+
+void pointGridMove(PointGrid &grid, int index, float x, float y)
+{
+    int cell = cellIndex(grid, x, y);
+    if (cell == grid.cellOf[index])
+        return;
+    unlinkPoint(grid, index);
+    linkPoint(grid, index, cell);
+}
+
+int pointGridNearest(const PointGrid &grid, const float *xs, const float *ys, float x, float y, float radius)
+{
+    if (grid.head.empty())
+        return -1;
+
+    int nearest = -1;
+    float best2 = radius * radius;
+    int cy1 = cellCoord(y + radius, grid.cellSize, grid.rows);
+    int cx1 = cellCoord(x + radius, grid.cellSize, grid.cols);
+    for (int cy = cellCoord(y - radius, grid.cellSize, grid.rows); cy <= cy1; cy++)
+    {
+        for (int cx = cellCoord(x - radius, grid.cellSize, grid.cols); cx <= cx1; cx++)
+        {
+            for (int i = grid.head[cy * grid.cols + cx]; i >= 0; i = grid.next[i])
+            {
+                float dx = x - xs[i], dy = y - ys[i];
+                float dist2 = dx * dx + dy * dy;
+                if (dist2 < best2 || (dist2 == best2 && (nearest < 0 || i < nearest)))
+                {
+                    best2 = dist2;
+                    nearest = i;
+                }
+            }
+        }
+    }
+    return nearest;
+}
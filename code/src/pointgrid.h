@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+
+// Uniform grid over 2D points stored elsewhere as separate x and y arrays, covering a fixed
+// extent (e.g. the window); points outside it are filed under the border cells.
+// The points of a cell form an intrusive doubly linked list, so inserting and
+// moving points never allocates once the per-point arrays have grown, and a
+// radius query only walks the few cells the search disc overlaps.
+struct PointGrid
+{
+    float cellSize = 1.0f;
+    int cols = 0, rows = 0;
+    std::vector<int> head;       // First point of each cell, -1 if empty
+    std::vector<int> next, prev; // Links between the points of a cell, -1 at the ends
+    std::vector<int> cellOf;     // Cell each point is filed under
+};
+
+void pointGridInit(PointGrid &grid, float cellSize, float width, float height);
+void pointGridClear(PointGrid &grid);
+void pointGridInsert(PointGrid &grid, int index, float x, float y);
+void pointGridMove(PointGrid &grid, int index, float x, float y);
+
+// Index of the point (xs[i], ys[i]) nearest to (x, y) within radius (lowest index on ties), or -1
+int pointGridNearest(const PointGrid &grid, const float *xs, const float *ys, float x, float y, float radius);
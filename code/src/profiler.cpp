@@ -0,0 +1,245 @@
+#include "profiler.h"
+#include "imgui.h"
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock profileClock;
+
+static const int historyLength = 240; // Frames kept per stage for graphs and percentiles
+static const int queryFrames = 4;     // GPU results are read this many frames late at most
+
+// Rolling window of samples in milliseconds
+struct ProfileHistory
+{
+    float samples[historyLength];
+    int next = 0;  // Slot the next sample goes to
+    int count = 0; // Valid samples, up to historyLength
+};
+
+static ProfileHistory cpuHistory[PROFILE_STAGE_COUNT];
+static ProfileHistory gpuHistory[PROFILE_STAGE_COUNT];
+static ProfileHistory frameHistory;
+
+static double cpuFrameMs[PROFILE_STAGE_COUNT]; // Accumulated over the current frame
+static bool cpuStageRan[PROFILE_STAGE_COUNT];
+static profileClock::time_point stageStart[PROFILE_STAGE_COUNT];
+static profileClock::time_point frameStart;
+
+static bool gpuTimersAvailable = false;
+static GLuint gpuQueries[queryFrames][PROFILE_STAGE_COUNT];
+static bool gpuQueryIssued[queryFrames][PROFILE_STAGE_COUNT];
+static bool gpuStageActive[PROFILE_STAGE_COUNT];
+static long long frameIndex = 0;
+static long long gpuResultsDropped = 0; // Queries reused before their result arrived
+
+static const char *stageNames[PROFILE_STAGE_COUNT] = {
+    "ImGui NewFrame", "ImGui Render", "Control polyline", "Piecewise Bezier", "VBO uploads", "Curve draws", "ImGui draw data",
+};
+
+const char *profileStageName(ProfileStage stage)
+{
+    return stageNames[stage];
+}
+
+static double millisecondsSince(profileClock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(profileClock::now() - start).count();
+}
+
+static void pushSample(ProfileHistory &history, float ms)
+{
+    history.samples[history.next] = ms;
+    history.next = (history.next + 1) % historyLength;
+    history.count = std::min(history.count + 1, historyLength);
+}
+
+static bool hasTimerQueries()
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 3 || (major == 3 && minor >= 3))
+        return true;
+    GLint extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    for (GLint i = 0; i < extensions; i++)
+    {
+        const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (name && strcmp(name, "GL_ARB_timer_query") == 0)
+            return true;
+    }
+    return false;
+}
+
+void profilerInit()
+{
+    gpuTimersAvailable = hasTimerQueries();
+    if (gpuTimersAvailable)
+        glGenQueries(queryFrames * PROFILE_STAGE_COUNT, &gpuQueries[0][0]);
+    memset(gpuQueryIssued, 0, sizeof(gpuQueryIssued));
+}
+
+void profilerShutdown()
+{
+    if (gpuTimersAvailable)
+        glDeleteQueries(queryFrames * PROFILE_STAGE_COUNT, &gpuQueries[0][0]);
+    gpuTimersAvailable = false;
+}
+
+// Read back every finished query, oldest frame first, without blocking
+static void collectGpuResults()
+{
+    for (int age = queryFrames - 1; age >= 1; age--)
+    {
+        if (frameIndex - age < 0)
+            continue;
+        int slot = (int)((frameIndex - age) % queryFrames);
+        for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+        {
+            if (!gpuQueryIssued[slot][stage])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(gpuQueries[slot][stage], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(gpuQueries[slot][stage], GL_QUERY_RESULT, &nanoseconds);
+            pushSample(gpuHistory[stage], (float)(nanoseconds * 1e-6));
+            gpuQueryIssued[slot][stage] = false;
+        }
+    }
+}
+
+void profilerBeginFrame()
+{
+    frameStart = profileClock::now();
+    memset(cpuFrameMs, 0, sizeof(cpuFrameMs));
+    memset(cpuStageRan, 0, sizeof(cpuStageRan));
+    if (!gpuTimersAvailable)
+        return;
+    collectGpuResults();
+    int slot = (int)(frameIndex % queryFrames);
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+    {
+        if (gpuQueryIssued[slot][stage])
+            gpuResultsDropped++;
+        gpuQueryIssued[slot][stage] = false;
+    }
+}
+
+void profilerEndFrame()
+{
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+    {
+        if (cpuStageRan[stage])
+            pushSample(cpuHistory[stage], (float)cpuFrameMs[stage]);
+    }
+    pushSample(frameHistory, (float)millisecondsSince(frameStart));
+    frameIndex++;
+}
+
+void profilerBeginStage(ProfileStage stage, bool gpu)
+{
+    stageStart[stage] = profileClock::now();
+    gpuStageActive[stage] = gpu && gpuTimersAvailable;
+    if (gpuStageActive[stage])
+        glBeginQuery(GL_TIME_ELAPSED, gpuQueries[frameIndex % queryFrames][stage]);
+}
+
+void profilerEndStage(ProfileStage stage)
+{
+    if (gpuStageActive[stage])
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuQueryIssued[frameIndex % queryFrames][stage] = true;
+        gpuStageActive[stage] = false;
+    }
+    profilerAddCpuTime(stage, millisecondsSince(stageStart[stage]));
+}
+
+void profilerAddCpuTime(ProfileStage stage, double ms)
+{
+    cpuFrameMs[stage] += ms;
+    cpuStageRan[stage] = true;
+}
+
+// p50, p95 and p99 of the samples in history, without allocating
+static void percentiles(const ProfileHistory &history, float result[3])
+{
+    static const float ranks[3] = {0.50f, 0.95f, 0.99f};
+    float sorted[historyLength];
+    memcpy(sorted, history.samples, history.count * sizeof(float));
+    for (int i = 0; i < 3; i++)
+    {
+        int k = std::min((int)(ranks[i] * history.count), history.count - 1);
+        std::nth_element(sorted, sorted + k, sorted + history.count);
+        result[i] = sorted[k];
+    }
+}
+
+static void showHistoryColumns(const ProfileHistory &history)
+{
+    if (history.count == 0)
+    {
+        ImGui::TextDisabled("-");
+        ImGui::NextColumn();
+        ImGui::NextColumn();
+        return;
+    }
+    float p[3];
+    percentiles(history, p);
+    ImGui::Text("%6.3f %6.3f %6.3f", p[0], p[1], p[2]);
+    ImGui::NextColumn();
+    // Oldest sample first once the window has wrapped around
+    int offset = history.count == historyLength ? history.next : 0;
+    ImGui::PushID(&history);
+    ImGui::PlotLines("", history.samples, history.count, offset, NULL, 0.0f, FLT_MAX, ImVec2(120, 20));
+    ImGui::PopID();
+    ImGui::NextColumn();
+}
+
+void showProfilerWindow()
+{
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Text("Times in ms as p50 / p95 / p99 over the last %d frames", historyLength);
+    if (!gpuTimersAvailable)
+        ImGui::TextDisabled("GPU timer queries unavailable on this context");
+    else if (gpuResultsDropped > 0)
+        ImGui::Text("GPU results dropped: %lld", gpuResultsDropped);
+    ImGui::Separator();
+
+    ImGui::Columns(5, "profilerStages");
+    ImGui::SetColumnWidth(0, 130);
+    ImGui::Text("Stage");
+    ImGui::NextColumn();
+    ImGui::Text("CPU");
+    ImGui::NextColumn();
+    ImGui::NextColumn();
+    ImGui::Text("GPU");
+    ImGui::NextColumn();
+    ImGui::NextColumn();
+    ImGui::Separator();
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+    {
+        ImGui::Text("%s", stageNames[stage]);
+        ImGui::NextColumn();
+        showHistoryColumns(cpuHistory[stage]);
+        if (gpuHistory[stage].count > 0)
+        {
+            showHistoryColumns(gpuHistory[stage]);
+        }
+        else
+        {
+            ImGui::NextColumn();
+            ImGui::NextColumn();
+        }
+    }
+    ImGui::Separator();
+    ImGui::Text("Whole frame");
+    ImGui::NextColumn();
+    showHistoryColumns(frameHistory);
+    ImGui::Columns(1);
+    ImGui::End();
+}
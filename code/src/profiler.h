@@ -0,0 +1,37 @@
+#pragma once
+#include "glloader.h"
+
+// Stages of one editor frame, in the order they run
+enum ProfileStage
+{
+    PROFILE_IMGUI_NEWFRAME,
+    PROFILE_IMGUI_RENDER,
+    PROFILE_CONTROL_POLYLINE,
+    PROFILE_PIECEWISE_BEZIER,
+    PROFILE_UPLOAD,
+    PROFILE_CURVE_DRAW,
+    PROFILE_IMGUI_DRAW,
+    PROFILE_STAGE_COUNT
+};
+
+const char *profileStageName(ProfileStage stage);
+
+// Query objects are created here, so call after the GL context is current.
+// GPU timings are disabled on contexts without timer queries (GL 3.3 / ARB_timer_query).
+void profilerInit();
+void profilerShutdown();
+
+// Brackets a frame. profilerBeginFrame() collects GPU results of earlier frames
+// that are already available; it never waits for the GPU.
+void profilerBeginFrame();
+void profilerEndFrame();
+
+// Times a stage on the CPU, and on the GPU when gpu is true. Stages must not overlap.
+void profilerBeginStage(ProfileStage stage, bool gpu = false);
+void profilerEndStage(ProfileStage stage);
+
+// Adds CPU time measured elsewhere (e.g. inside updateCurve) to the current frame
+void profilerAddCpuTime(ProfileStage stage, double ms);
+
+// Rolling graphs and p50/p95/p99 per stage
+void showProfilerWindow();
@@ -0,0 +1,151 @@
+#include "programcache.h"
+#include "cachedir.h"
+#include "trace.h"
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const char programCacheMagic[8] = {'C', 'R', 'V', 'P', 'R', 'O', 'G', '1'};
+
+// Followed by size bytes of program binary
+struct ProgramCacheHeader
+{
+    char magic[8];
+    uint64_t key;
+    uint32_t format; // GL_PROGRAM_BINARY_FORMAT of the binary
+    uint32_t size;
+};
+
+static std::string cacheDirectory; // Empty while disabled
+
+static std::string defaultCacheDirectory()
+{
+    if (const char *dir = getenv("CURVE_PROGRAM_CACHE"))
+        return dir;
+    return userCacheDirectory();
+}
+
+void programCacheInit(const char *directory)
+{
+    cacheDirectory = directory ? directory : defaultCacheDirectory();
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    while (glGetError() != GL_NO_ERROR) // The query itself fails before ARB_get_program_binary
+        ;
+    std::error_code error;
+    if (formats <= 0 || cacheDirectory.empty() || (std::filesystem::create_directories(cacheDirectory, error), error))
+        cacheDirectory.clear();
+}
+
+bool programCacheEnabled()
+{
+    return !cacheDirectory.empty();
+}
+
+static uint64_t hashString(uint64_t hash, const char *s)
+{
+    return cacheHashBytes(hash, s ? s : "", s ? strlen(s) + 1 : 1); // The terminator separates the strings
+}
+
+uint64_t programCacheKey(const GLenum *types, const char *const *sources, int count)
+{
+    uint64_t hash = cacheHashBasis;
+    hash = hashString(hash, (const char *)glGetString(GL_VENDOR));
+    hash = hashString(hash, (const char *)glGetString(GL_RENDERER));
+    hash = hashString(hash, (const char *)glGetString(GL_VERSION));
+    for (int i = 0; i < count; i++)
+    {
+        hash = cacheHashBytes(hash, &types[i], sizeof(types[i]));
+        hash = hashString(hash, sources[i]);
+    }
+    return hash;
+}
+
+static std::string cacheFile(uint64_t key)
+{
+    char name[40];
+    snprintf(name, sizeof(name), "/program-%016llx.bin", (unsigned long long)key);
+    return cacheDirectory + name;
+}
+
+GLuint programCacheLoad(uint64_t key)
+{
+    TRACE_ZONE("programCacheLoad");
+    if (cacheDirectory.empty())
+        return 0;
+    std::string filename = cacheFile(key);
+    FILE *input = fopen(filename.c_str(), "rb");
+    if (input == NULL)
+        return 0;
+
+    // The binary must fill the rest of the file: a corrupt size never gets allocated
+    long fileSize = -1;
+    if (fseek(input, 0, SEEK_END) == 0)
+        fileSize = ftell(input);
+    rewind(input);
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    bool ok = fread(&header, sizeof(header), 1, input) == 1 &&
+              memcmp(header.magic, programCacheMagic, sizeof(header.magic)) == 0 && header.key == key &&
+              fileSize >= 0 && (uint64_t)fileSize == sizeof(header) + (uint64_t)header.size;
+    if (ok)
+    {
+        binary.resize(header.size);
+        ok = fread(binary.data(), 1, binary.size(), input) == binary.size();
+    }
+    fclose(input);
+
+    GLuint program = 0;
+    GLint linkOk = GL_FALSE;
+    if (ok)
+    {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        glGetProgramiv(program, GL_LINK_STATUS, &linkOk);
+    }
+    if (!linkOk)
+    {
+        // Truncated, or a binary the driver no longer accepts: rebuild it
+        if (program)
+            glDeleteProgram(program);
+        remove(filename.c_str());
+        return 0;
+    }
+    return program;
+}
+
+void programCacheStore(uint64_t key, GLuint program)
+{
+    TRACE_ZONE("programCacheStore");
+    if (cacheDirectory.empty())
+        return;
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0)
+        return;
+
+    ProgramCacheHeader header;
+    memcpy(header.magic, programCacheMagic, sizeof(header.magic));
+    header.key = key;
+    std::vector<char> binary(size);
+    GLenum format = 0;
+    glGetProgramBinary(program, size, &size, &format, binary.data());
+    header.format = format;
+    header.size = (uint32_t)size;
+
+    // Write a temporary file and rename it, so that a concurrent start never loads half a binary
+    std::string filename = cacheFile(key), temporary = cacheTemporaryFile(filename);
+    FILE *output = fopen(temporary.c_str(), "wb");
+    if (output == NULL)
+        return;
+    bool ok = fwrite(&header, sizeof(header), 1, output) == 1 && fwrite(binary.data(), 1, size, output) == (size_t)size;
+    ok = fclose(output) == 0 && ok;
+    std::error_code error;
+    if (ok)
+        std::filesystem::rename(temporary, filename, error);
+    if (!ok || error)
+        remove(temporary.c_str());
+}
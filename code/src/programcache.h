@@ -0,0 +1,22 @@
+#pragma once
+#include "glloader.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// On-disk cache of linked programs (glGetProgramBinary/glProgramBinary, OpenGL 4.1
+// or ARB_get_program_binary). Entries are keyed by a hash of the driver (vendor,
+// renderer, version strings) and of every shader stage's type and source, so a
+// driver update or a shader edit simply misses. Unreadable or rejected entries
+// count as misses too: the caller then compiles and links as usual.
+
+// Use directory for the cache files. NULL picks $CURVE_PROGRAM_CACHE, else the
+// per-user cache directory (cachedir.h); an empty string disables the cache. Needs a current
+// context: without program binary formats the cache stays disabled.
+void programCacheInit(const char *directory = NULL);
+bool programCacheEnabled();
+
+uint64_t programCacheKey(const GLenum *types, const char *const *sources, int count);
+// Returns a linked program, or 0 on a miss
+GLuint programCacheLoad(uint64_t key);
+// Call glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE) before linking
+void programCacheStore(uint64_t key, GLuint program);
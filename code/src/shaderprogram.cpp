@@ -0,0 +1,255 @@
+#include "shaderprogram.h"
+#include "embeddedshaders.h"
+#include "programcache.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+
+// The whole file, NUL-terminated, or NULL if any step fails; the file is always closed
+static char *readFile(const char *filename)
+{
+    FILE *input = fopen(filename, "rb");
+    if (input == NULL)
+        return NULL;
+
+    char *content = NULL;
+    long size = -1;
+    if (fseek(input, 0, SEEK_END) == 0 && (size = ftell(input)) >= 0 && fseek(input, 0, SEEK_SET) == 0)
+    {
+        /*if using c-compiler: dont cast malloc's return value*/
+        content = (char *)malloc((size_t)size + 1);
+        if (content != NULL && fread(content, 1, (size_t)size, input) != (size_t)size)
+        {
+            free(content); // A short read or an error: never hand out a partly filled buffer
+            content = NULL;
+        }
+    }
+    fclose(input);
+    if (content != NULL)
+        content[size] = '\0';
+    return content;
+}
+
+char *getShaderCode(const char *name)
+{
+    if (const char *dir = getenv("CURVE_SHADER_DIR"))
+        return readFile((std::string(dir) + "/" + name).c_str());
+    for (int i = 0; i < embeddedShaderCount; i++)
+    {
+        if (strcmp(embeddedShaders[i].name, name) == 0)
+            return strdup(embeddedShaders[i].source);
+    }
+    return NULL;
+}
+
+static GLuint compileShader(const char *name, const char *source, GLenum type)
+{
+    GLuint res = glCreateShader(type);
+    glShaderSource(res, 1, &source, NULL);
+    glCompileShader(res);
+    GLint compile_ok = GL_FALSE;
+    glGetShaderiv(res, GL_COMPILE_STATUS, &compile_ok);
+    if (compile_ok == GL_FALSE)
+    {
+        std::cout << "Error in compilation of :" << name << std::endl;
+        glDeleteShader(res);
+        return 0;
+    }
+    return res;
+}
+
+GLuint createShader(const char *name, GLenum type)
+{
+    char *source = getShaderCode(name);
+    if (source == NULL)
+    {
+        fprintf(stderr, "No shader %s\n", name);
+        return 0;
+    }
+    GLuint res = compileShader(name, source, type);
+    free(source);
+    return res;
+}
+
+// A program being built: loaded from the cache, or compiled and linked without
+// waiting for the result, which endProgram() checks
+struct PendingProgram
+{
+    const char *names[4];
+    char *sources[4];
+    GLuint program, shaders[4];
+    int count;
+    uint64_t key;
+    bool cached, ok;
+};
+
+// Load the program of the count stages from the cache, else start compiling and linking it
+static void beginProgram(PendingProgram &pending, const char *const *names, const GLenum *types, int count)
+{
+    pending = PendingProgram{};
+    pending.count = count;
+    pending.ok = true;
+    for (int i = 0; i < count && pending.ok; i++)
+    {
+        pending.names[i] = names[i];
+        if ((pending.sources[i] = getShaderCode(names[i])) == NULL)
+        {
+            fprintf(stderr, "No shader %s\n", names[i]);
+            pending.ok = false;
+        }
+    }
+    if (!pending.ok)
+        return;
+
+    if (programCacheEnabled())
+    {
+        pending.key = programCacheKey(types, pending.sources, count);
+        pending.program = programCacheLoad(pending.key);
+        pending.cached = pending.program != 0;
+    }
+    if (pending.cached)
+        return;
+
+    // Create program object and link shader objects
+    pending.program = glCreateProgram();
+    for (int i = 0; i < count; i++)
+    {
+        pending.shaders[i] = glCreateShader(types[i]);
+        glShaderSource(pending.shaders[i], 1, &pending.sources[i], NULL);
+        glCompileShader(pending.shaders[i]);
+        glAttachShader(pending.program, pending.shaders[i]);
+    }
+    if (programCacheEnabled())
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(pending.program);
+}
+
+// Wait for the program, cache it, and return it; 0 if it did not build
+static GLuint endProgram(PendingProgram &pending)
+{
+    if (pending.ok && !pending.cached)
+    {
+        for (int i = 0; i < pending.count && pending.ok; i++)
+        {
+            GLint compile_ok = GL_FALSE;
+            glGetShaderiv(pending.shaders[i], GL_COMPILE_STATUS, &compile_ok);
+            if (compile_ok == GL_FALSE)
+            {
+                std::cout << "Error in compilation of :" << pending.names[i] << std::endl;
+                pending.ok = false;
+            }
+        }
+        GLint link_ok = GL_FALSE;
+        if (pending.ok)
+            glGetProgramiv(pending.program, GL_LINK_STATUS, &link_ok);
+        if (pending.ok && !link_ok)
+        {
+            std::cout << "Linking error " << std::endl;
+            pending.ok = false;
+        }
+        if (pending.ok && programCacheEnabled())
+            programCacheStore(pending.key, pending.program);
+    }
+    if (!pending.ok && pending.program)
+    {
+        glDeleteProgram(pending.program);
+        pending.program = 0;
+    }
+
+    for (int i = 0; i < pending.count; i++)
+    {
+        if (pending.shaders[i])
+            glDeleteShader(pending.shaders[i]); // Freed along with the program
+        free(pending.sources[i]);
+    }
+    return pending.program;
+}
+
+static GLuint buildProgram(const char *const *names, const GLenum *types, int count)
+{
+    PendingProgram pending;
+    beginProgram(pending, names, types, count);
+    return endProgram(pending);
+}
+
+unsigned int createProgram(const char *vshader_name, const char *fshader_name,
+                           const char *tcshader_name, const char *teshader_name)
+{
+    TRACE_ZONE("createProgram");
+    const char *names[4] = {vshader_name, fshader_name};
+    GLenum types[4] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    int count = 2;
+    if (tcshader_name)
+    {
+        names[count] = tcshader_name;
+        types[count++] = GL_TESS_CONTROL_SHADER;
+    }
+    if (teshader_name)
+    {
+        names[count] = teshader_name;
+        types[count++] = GL_TESS_EVALUATION_SHADER;
+    }
+    return buildProgram(names, types, count);
+}
+
+unsigned int createComputeProgram(const char *cshader_name)
+{
+    TRACE_ZONE("createComputeProgram");
+    const GLenum type = GL_COMPUTE_SHADER;
+    return buildProgram(&cshader_name, &type, 1);
+}
+
+struct EditorProgramStages
+{
+    const char *names[4];
+    GLenum types[4];
+    int count;
+    int minVersion; // Major * 10 + minor
+};
+
+static const EditorProgramStages editorProgramStages[EDITOR_PROGRAM_COUNT] = {
+    {{"vshader.vs", "fshader.fs"}, {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER}, 2, 0},
+    {{"bezier.vs", "fshader.fs"}, {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER}, 2, 0},
+    {{"bezierpatch.vs", "fshader.fs", "bezier.tcs", "bezier.tes"},
+     {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER}, 4, 40},
+    {{"bezier.comp"}, {GL_COMPUTE_SHADER}, 1, 43},
+};
+
+static int contextVersion()
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major * 10 + minor;
+}
+
+static PendingProgram pendingEditorPrograms[EDITOR_PROGRAM_COUNT];
+static bool editorProgramsStarted = false;
+
+void startEditorPrograms()
+{
+    TRACE_ZONE("startEditorPrograms");
+    int version = contextVersion();
+    for (int p = 0; p < EDITOR_PROGRAM_COUNT; p++)
+    {
+        const EditorProgramStages &stages = editorProgramStages[p];
+        if (version >= stages.minVersion)
+            beginProgram(pendingEditorPrograms[p], stages.names, stages.types, stages.count);
+        else
+            pendingEditorPrograms[p] = PendingProgram{};
+    }
+    editorProgramsStarted = true;
+}
+
+void finishEditorPrograms(GLuint programs[EDITOR_PROGRAM_COUNT])
+{
+    TRACE_ZONE("finishEditorPrograms");
+    if (!editorProgramsStarted)
+        startEditorPrograms();
+    for (int p = 0; p < EDITOR_PROGRAM_COUNT; p++)
+        programs[p] = endProgram(pendingEditorPrograms[p]);
+    editorProgramsStarted = false;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "glloader.h"
+#include <stddef.h>
+
+// Shaders are named by their file name in shaders/ (e.g. "vshader.vs") and built from
+// the sources embedded in the executable. Set CURVE_SHADER_DIR to read them from that
+// directory instead, to try shader edits without rebuilding. Linked programs come
+// from the program binary cache (programcache.h) when it has them.
+
+GLuint createShader(const char *name, GLenum type);
+// Tessellation control and evaluation shaders are optional (OpenGL 4.0)
+unsigned int createProgram(const char *vshader_name, const char *fshader_name,
+                           const char *tcshader_name = NULL, const char *teshader_name = NULL);
+unsigned int createComputeProgram(const char *cshader_name); // OpenGL 4.3
+// Source of shader name, malloc'd; NULL if there is no such shader
+char *getShaderCode(const char *name);
+
+// The programs of the editor
+enum EditorProgram
+{
+    PROGRAM_CURVE,               // vshader.vs, fshader.fs: points and line strips
+    PROGRAM_BEZIER_VERTEX,       // bezier.vs, fshader.fs: segments sampled in the vertex shader
+    PROGRAM_BEZIER_TESSELLATION, // bezierpatch.vs, fshader.fs, bezier.tcs, bezier.tes (OpenGL 4.0)
+    PROGRAM_BEZIER_COMPUTE,      // bezier.comp (OpenGL 4.3)
+    EDITOR_PROGRAM_COUNT
+};
+
+// Build every editor program the current context supports; 0 for the others. The
+// start issues all the compiles and links and finish waits for them: with
+// KHR_parallel_shader_compile the driver builds them on its own threads meanwhile.
+void startEditorPrograms();
+void finishEditorPrograms(GLuint programs[EDITOR_PROGRAM_COUNT]); // Also starts them if needed
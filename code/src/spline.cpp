@@ -0,0 +1,237 @@
+#include "spline.h"
+#include "threadpool.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+// Shorter curves are solved with the Thomas algorithm: the partitioned solver does
+// twice the arithmetic, which only pays off spread over cores on long curves.
+static const int splineParallelCutoff = 1 << 17;
+static const int splinePartsPerThread = 4; // Lets idle threads steal parts
+// Ratio between neighbouring entries of a row of the inverse away from the diagonal:
+// the root of x^2 + 4x + 1 inside the unit circle, 2 - sqrt(3)
+static const float splineDecay = 0.26794919f;
+
+const char *tangentModeName(TangentMode mode)
+{
+    switch (mode)
+    {
+    case TANGENTS_NATURAL_SPLINE:
+        return "Natural spline (C2)";
+    default:
+        return "Central differences (C1)";
+    }
+}
+
+static inline float splineDiagonal(int i, int n)
+{
+    return (i == 0 || i == n) ? 2.0f : 4.0f;
+}
+
+// Right-hand side of row i; the end rows only see their one neighbour
+static inline point2d splineRight(const point2d *B, int i, int n)
+{
+    const point2d &prev = B[i > 0 ? i - 1 : 0], &next = B[i < n ? i + 1 : n];
+    return {3.0f * (next.x - prev.x), 3.0f * (next.y - prev.y)};
+}
+
+// Thomas algorithm on rows lo..hi, with T[lo - 1] and T[hi + 1] (where they exist)
+// held fixed. c needs hi - lo + 1 entries.
+static void solveSplineRows(const point2d *B, int n, int lo, int hi, point2d *T, float *c)
+{
+    // Forward sweep: eliminate the sub-diagonal
+    float m = 1.0f / splineDiagonal(lo, n);
+    point2d r = splineRight(B, lo, n);
+    if (lo > 0)
+        r = {r.x - T[lo - 1].x, r.y - T[lo - 1].y};
+    point2d last = hi < n ? T[hi + 1] : point2d{0.0f, 0.0f};
+    c[0] = m;
+    T[lo] = {r.x * m, r.y * m};
+    for (int i = lo + 1; i <= hi; i++)
+    {
+        m = 1.0f / (splineDiagonal(i, n) - c[i - lo - 1]);
+        r = splineRight(B, i, n);
+        c[i - lo] = m;
+        T[i] = {(r.x - T[i - 1].x) * m, (r.y - T[i - 1].y) * m};
+    }
+    T[hi] = {T[hi].x - last.x * m, T[hi].y - last.y * m};
+
+    // Back substitution
+    for (int i = hi - 1; i >= lo; i--)
+    {
+        T[i].x -= c[i - lo] * T[i + 1].x;
+        T[i].y -= c[i - lo] * T[i + 1].y;
+    }
+}
+
+void solveNaturalSplineThomas(const point2d *B, int count, point2d *T, SplineWorkspace &work)
+{
+    TRACE_ZONE("solveNaturalSplineThomas");
+    if (count < 2)
+    {
+        if (count == 1)
+            T[0] = {0.0f, 0.0f};
+        return;
+    }
+    if ((int)work.coefficients.size() < count)
+        work.coefficients.resize(count);
+    solveSplineRows(B, count - 1, 0, count - 1, T, work.coefficients.data());
+}
+
+// Rows lo..hi of the system, without their couplings to T[lo - 1] and T[hi + 1].
+// T[lo..hi] gets the solution for the right-hand side alone. v gets the left spike,
+// how much each row moves per unit of T[lo - 1], and c, once done, the right spike:
+// the same for T[hi + 1]. Both decay by about 2 - sqrt(3) per row.
+static void solveSplinePart(const point2d *B, int n, int lo, int hi, point2d *T, float *c, float *v)
+{
+    float m = 1.0f / splineDiagonal(lo, n);
+    point2d r = splineRight(B, lo, n);
+    c[lo] = m;
+    T[lo] = {r.x * m, r.y * m};
+    v[lo] = -m;
+    for (int i = lo + 1; i <= hi; i++)
+    {
+        m = 1.0f / (splineDiagonal(i, n) - c[i - 1]);
+        r = splineRight(B, i, n);
+        c[i] = m;
+        T[i] = {(r.x - T[i - 1].x) * m, (r.y - T[i - 1].y) * m};
+        v[i] = -v[i - 1] * m;
+    }
+
+    float w = -m; // The right spike only enters at row hi
+    c[hi] = w;
+    for (int i = hi - 1; i >= lo; i--)
+    {
+        float ci = c[i];
+        T[i].x -= ci * T[i + 1].x;
+        T[i].y -= ci * T[i + 1].y;
+        v[i] -= ci * v[i + 1];
+        w = -ci * w;
+        c[i] = w;
+    }
+}
+
+void solveNaturalSplinePartitioned(const point2d *B, int count, point2d *T, SplineWorkspace &work, int parts)
+{
+    TRACE_ZONE("solveNaturalSplinePartitioned");
+    parts = std::min(parts, count / 3); // Every part keeps at least one row
+    if (parts < 2)
+    {
+        solveNaturalSplineThomas(B, count, T, work);
+        return;
+    }
+    int n = count - 1;
+    if ((int)work.coefficients.size() < count)
+        work.coefficients.resize(count);
+    if ((int)work.spikes.size() < count)
+        work.spikes.resize(count);
+    if ((int)work.reducedRight.size() < parts)
+    {
+        work.reducedLower.resize(parts);
+        work.reducedDiagonal.resize(parts);
+        work.reducedUpper.resize(parts);
+        work.reducedRight.resize(parts);
+    }
+    float *c = work.coefficients.data(), *v = work.spikes.data();
+
+    // Separator k, for 0 < k < parts, is row separator(k); part k lies between
+    // separators k and k + 1, where separator(0) and separator(parts) are past the ends
+    auto separator = [count, parts](int k)
+    {
+        return k == 0 ? -1 : k == parts ? count : (int)((long long)k * count / parts);
+    };
+    ThreadPool &pool = globalThreadPool();
+    pool.parallelFor(0, parts, 1, [&](int lo, int hi)
+                     {
+                         for (int k = lo; k < hi; k++)
+                         {
+                             TRACE_ZONE("spline part");
+                             solveSplinePart(B, n, separator(k) + 1, separator(k + 1) - 1, T, c, v);
+                         }
+                     });
+
+    // The separators' rows, with their neighbours written in terms of the separators:
+    // T[p - 1] = T[p - 1] + v[p - 1] X[k - 1] + c[p - 1] X[k] (last row of part k - 1)
+    // T[p + 1] = T[p + 1] + v[p + 1] X[k] + c[p + 1] X[k + 1] (first row of part k)
+    int reduced = parts - 1;
+    float *lower = work.reducedLower.data(), *diagonal = work.reducedDiagonal.data(), *upper = work.reducedUpper.data();
+    point2d *right = work.reducedRight.data();
+    for (int j = 0; j < reduced; j++)
+    {
+        int p = separator(j + 1);
+        point2d r = splineRight(B, p, n);
+        lower[j] = j > 0 ? v[p - 1] : 0.0f;
+        diagonal[j] = splineDiagonal(p, n) + c[p - 1] + v[p + 1];
+        upper[j] = j + 1 < reduced ? c[p + 1] : 0.0f;
+        right[j] = {r.x - T[p - 1].x - T[p + 1].x, r.y - T[p - 1].y - T[p + 1].y};
+    }
+
+    // Thomas algorithm on the separators
+    for (int j = 0; j < reduced; j++)
+    {
+        float m = 1.0f / (diagonal[j] - (j > 0 ? lower[j] * upper[j - 1] : 0.0f));
+        upper[j] *= m;
+        right[j] = {(right[j].x - (j > 0 ? lower[j] * right[j - 1].x : 0.0f)) * m,
+                    (right[j].y - (j > 0 ? lower[j] * right[j - 1].y : 0.0f)) * m};
+    }
+    for (int j = reduced - 1; j >= 0; j--)
+    {
+        point2d x = right[j];
+        if (j + 1 < reduced)
+            x = {x.x - upper[j] * right[j + 1].x, x.y - upper[j] * right[j + 1].y};
+        right[j] = x;
+        T[separator(j + 1)] = x;
+    }
+
+    // Add the separators' influence to every part
+    pool.parallelFor(0, parts, 1, [&](int lo, int hi)
+                     {
+                         for (int k = lo; k < hi; k++)
+                         {
+                             point2d left = k > 0 ? T[separator(k)] : point2d{0.0f, 0.0f};
+                             point2d next = k + 1 < parts ? T[separator(k + 1)] : point2d{0.0f, 0.0f};
+                             for (int i = separator(k) + 1; i < separator(k + 1); i++)
+                             {
+                                 T[i].x += v[i] * left.x + c[i] * next.x;
+                                 T[i].y += v[i] * left.y + c[i] * next.y;
+                             }
+                         }
+                     });
+}
+
+void solveNaturalSpline(const point2d *B, int count, point2d *T, SplineWorkspace &work)
+{
+    ThreadPool &pool = globalThreadPool();
+    if (count < splineParallelCutoff || pool.size() == 1)
+        solveNaturalSplineThomas(B, count, T, work);
+    else
+        solveNaturalSplinePartitioned(B, count, T, work, splinePartsPerThread * pool.size());
+}
+
+SplinePatch updateNaturalSpline(const point2d *B, int count, point2d *T, int first, int last, float moved,
+                                float tolerance, SplineWorkspace &work)
+{
+    TRACE_ZONE("updateNaturalSpline");
+    int n = count - 1;
+    // The moved nodes change the right-hand side of rows first - 1..last + 1 by at most
+    // 6 moved in all, and row j of the inverse is bounded by splineDecay^|j - k|: rows
+    // that far from the changed ones move by less than the tolerance
+    float change = 6.0f * moved;
+    int reach = 1;
+    if (change > tolerance)
+        reach = std::max(1, (int)std::ceil(std::log(tolerance / change) / std::log(splineDecay)));
+    SplinePatch patch;
+    patch.first = std::max(0, first - reach);
+    patch.last = std::min(n, last + reach);
+    patch.errorBound = 0.0f;
+    if (patch.first > 0 || patch.last < n)
+        patch.errorBound = change * std::pow(splineDecay, (float)reach);
+    if (count < 2)
+        return patch;
+
+    int rows = patch.last - patch.first + 1;
+    if ((int)work.coefficients.size() < rows)
+        work.coefficients.resize(rows);
+    solveSplineRows(B, n, patch.first, patch.last, T, work.coefficients.data());
+    return patch;
+}
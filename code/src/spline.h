@@ -0,0 +1,58 @@
+#pragma once
+#include "tessellate.h"
+#include <vector>
+
+// How the tangents of the interpolated points are chosen
+enum TangentMode
+{
+    TANGENTS_CENTRAL_DIFFERENCE, // Local: (B[i+1] - B[i-1]) / 2, a C1 curve
+    TANGENTS_NATURAL_SPLINE      // Global: the natural cubic spline, a C2 curve
+};
+
+const char *tangentModeName(TangentMode mode);
+
+// Natural cubic spline through nodes B[0..n] with uniform parameters: the tangents T
+// (Bezier handles at B +- T/3, as in curve.cpp) for which neighbouring segments share
+// their second derivative, and the ends have none. They solve the tridiagonal system
+//   2 T[0] + T[1]            = 3 (B[1] - B[0])
+//   T[i-1] + 4 T[i] + T[i+1] = 3 (B[i+1] - B[i-1])
+//   T[n-1] + 2 T[n]          = 3 (B[n] - B[n-1])
+// Both solvers are O(n). Their scratch space lives in a SplineWorkspace that only
+// grows, so solving never allocates once it has seen the largest curve.
+struct SplineWorkspace
+{
+    std::vector<float> coefficients, spikes; // n + 1 each
+    std::vector<float> reducedLower, reducedDiagonal, reducedUpper;
+    std::vector<point2d> reducedRight;
+};
+
+// Thomas algorithm: a forward and a backward sweep on the calling thread
+void solveNaturalSplineThomas(const point2d *nodes, int count, point2d *tangents, SplineWorkspace &work);
+
+// Partition method: separators split the curve into parts that are solved
+// independently on the global thread pool, each with the two "spikes" that carry the
+// influence of its neighbouring separators. A tridiagonal system of the separators
+// alone then gives them, and one more parallel pass the rest. About twice the
+// arithmetic of the Thomas algorithm, so it only wins with several cores.
+void solveNaturalSplinePartitioned(const point2d *nodes, int count, point2d *tangents, SplineWorkspace &work,
+                                   int parts);
+
+// Thomas for short curves, partitioned across the thread pool for long ones
+void solveNaturalSpline(const point2d *nodes, int count, point2d *tangents, SplineWorkspace &work);
+
+// Tangents T[first..last] re-solved by updateNaturalSpline, and a bound on how far
+// any tangent may still be from the full solution
+struct SplinePatch
+{
+    int first, last;
+    float errorBound;
+};
+
+// After nodes first..last moved, by at most moved summed over them (the larger of
+// the x and y change of each), patch the tangents of a solved spline. The influence
+// of a node decays by 2 - sqrt(3) per row, so only the rows it moves by more than
+// tolerance are re-solved, with their neighbours held fixed: O(log(moved / tolerance))
+// whatever the length of the curve. The tolerance bounds the error of each patch;
+// successive patches add up.
+SplinePatch updateNaturalSpline(const point2d *nodes, int count, point2d *tangents, int first, int last,
+                                float moved, float tolerance, SplineWorkspace &work);
@@ -0,0 +1,111 @@
+#include "startup.h"
+#include "fontcache.h"
+#include "imgui.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct StartupPhase
+{
+    const char *name;
+    double beginMs, endMs;
+};
+
+static std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now();
+static std::mutex startupMutex;
+static std::vector<StartupPhase> startupPhases;
+
+void startupBegin()
+{
+    std::lock_guard<std::mutex> lock(startupMutex);
+    startupStart = std::chrono::steady_clock::now();
+    startupPhases.clear();
+}
+
+double startupElapsedMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+}
+
+void startupRecord(const char *phase, double beginMs)
+{
+    double endMs = startupElapsedMs();
+    std::lock_guard<std::mutex> lock(startupMutex);
+    startupPhases.push_back(StartupPhase{phase, beginMs, endMs});
+}
+
+void startupPrintReport(FILE *output)
+{
+    std::lock_guard<std::mutex> lock(startupMutex);
+    std::vector<StartupPhase> phases = startupPhases;
+    std::stable_sort(phases.begin(), phases.end(),
+                     [](const StartupPhase &a, const StartupPhase &b) { return a.beginMs < b.beginMs; });
+    fprintf(output, "%-28s %10s %10s %10s\n", "startup phase", "begin ms", "end ms", "ms");
+    double firstFrameMs = -1.0;
+    for (const StartupPhase &phase : phases)
+    {
+        fprintf(output, "%-28s %10.2f %10.2f %10.2f\n", phase.name, phase.beginMs, phase.endMs, phase.endMs - phase.beginMs);
+        if (strcmp(phase.name, "first frame") == 0)
+            firstFrameMs = phase.endMs;
+    }
+    if (firstFrameMs >= 0.0)
+        fprintf(output, "time to first frame: %.2f ms\n", firstFrameMs);
+}
+
+// Font atlas
+
+static std::thread fontThread;
+static ImFontAtlas *builtAtlas = NULL;
+static std::string builtIniData;
+static bool builtAtlasCached = false;
+
+// An empty cacheDirectory picks the per-user one
+static void buildFontAtlas(std::string cacheDirectory, std::string iniFilename)
+{
+    TRACE_ZONE("buildFontAtlas");
+    double begin = startupElapsedMs();
+    builtAtlas = IM_NEW(ImFontAtlas)();
+    builtAtlasCached = buildFontAtlasCached(builtAtlas, cacheDirectory.empty() ? NULL : cacheDirectory.c_str());
+    startupRecord(builtAtlasCached ? "font atlas (cached)" : "font atlas (built)", begin);
+
+    builtIniData.clear();
+    if (iniFilename.empty())
+        return;
+    begin = startupElapsedMs();
+    if (FILE *input = fopen(iniFilename.c_str(), "rb"))
+    {
+        char buffer[4096];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), input)) > 0)
+            builtIniData.append(buffer, size);
+        fclose(input);
+    }
+    startupRecord("read imgui.ini", begin);
+}
+
+void startFontAtlasBuild(const char *cacheDirectory, const char *iniFilename, bool worker)
+{
+    std::string directory = cacheDirectory ? cacheDirectory : "", ini = iniFilename ? iniFilename : "";
+    if (worker)
+        fontThread = std::thread(buildFontAtlas, directory, ini);
+    else
+        buildFontAtlas(directory, ini);
+}
+
+ImFontAtlas *finishFontAtlasBuild(std::string *iniData, bool *cached)
+{
+    if (fontThread.joinable())
+        fontThread.join();
+    if (iniData)
+        iniData->swap(builtIniData);
+    if (cached)
+        *cached = builtAtlasCached;
+    ImFontAtlas *atlas = builtAtlas;
+    builtAtlas = NULL;
+    return atlas;
+}
+
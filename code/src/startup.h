@@ -0,0 +1,24 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+
+struct ImFontAtlas;
+
+// Time to first frame. Each startup phase is recorded with the times it began and
+// ended, in milliseconds since startupBegin(). Phases run on worker threads overlap
+// those of the main thread.
+void startupBegin();
+double startupElapsedMs();
+// Record phase as running from beginMs until now; safe from any thread
+void startupRecord(const char *phase, double beginMs);
+// Every recorded phase in order of its start, then the time to first frame: the end
+// of the phase named "first frame"
+void startupPrintReport(FILE *output);
+
+// Off the critical path to the first frame: build a font atlas holding ImGui's default
+// font (buildFontAtlasCached; a NULL cacheDirectory picks the per-user one) and read
+// the file iniFilename unless it is NULL, on a worker thread unless worker is false.
+// Must finish before ImGui::CreateContext(): ImGui counts the worker's allocations in
+// the current context. The caller owns the atlas.
+void startFontAtlasBuild(const char *cacheDirectory, const char *iniFilename, bool worker);
+ImFontAtlas *finishFontAtlasBuild(std::string *iniData = NULL, bool *cached = NULL);
@@ -0,0 +1,278 @@
+#include "tessellate.h"
+#include "tessellator.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TESSELLATE_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+void buildBernsteinTable(BernsteinTable &table, int samples)
+{
+    int padded = (samples + 7) & ~7;
+    float interval = 1.0f / (samples - 1);
+
+    table.samples = samples;
+    for (int j = 0; j < 4; j++)
+        table.w[j].assign(padded, 0.0f);
+
+    for (int k = 0; k < samples; k++)
+    {
+        float t = k * interval;
+        float v = 1.0f - t;
+        table.w[0][k] = v * v * v;
+        table.w[1][k] = 3.0f * v * v * t;
+        table.w[2][k] = 3.0f * v * t * t;
+        table.w[3][k] = t * t * t;
+    }
+}
+
+static void sampleCubicScalar(const point2d ctrl[4], const BernsteinTable &table, int firstSample, float *out)
+{
+    const float *b0 = table.w[0].data(), *b1 = table.w[1].data();
+    const float *b2 = table.w[2].data(), *b3 = table.w[3].data();
+    for (int k = firstSample; k < table.samples; k++, out += 2)
+    {
+        out[0] = b0[k] * ctrl[0].x + b1[k] * ctrl[1].x + b2[k] * ctrl[2].x + b3[k] * ctrl[3].x;
+        out[1] = b0[k] * ctrl[0].y + b1[k] * ctrl[1].y + b2[k] * ctrl[2].y + b3[k] * ctrl[3].y;
+    }
+}
+
+// With P(t) = a t^3 + b t^2 + c t + d and step h = 1 / (n - 1), the differences
+//     d1 = a h^3 + b h^2 + c h,   d2 = 6 a h^3 + 2 b h^2,   d3 = 6 a h^3
+// are accumulated in float, each add contributing a relative error of at most
+// u = 2^-24. d3 is exact, d2 drifts by k u |d2|, d1 by k^2/2 u |d2| + k u |d1|, and
+// the position after k steps by at most
+//     u (k^3/6 |d2| + k^2/2 |d1| + k max|P|)
+// which for k <= n gives |error| <= n u (|a| + |b|/3 + (|a| + |b| + |c|)/2 + max|P|).
+// The error therefore grows linearly with the sample count: for a curve in NDC
+// (|P| <= 1, coefficients of a few units) and n = 1024 it stays around 1e-4, well
+// under a pixel. The last sample is snapped to B3 so that segments still join exactly.
+void sampleCubicForwardDifference(const point2d ctrl[4], int samples, int firstSample, float *out)
+{
+    float h = 1.0f / (samples - 1);
+    float h2 = h * h, h3 = h2 * h;
+
+    float ax = -ctrl[0].x + 3.0f * ctrl[1].x - 3.0f * ctrl[2].x + ctrl[3].x;
+    float ay = -ctrl[0].y + 3.0f * ctrl[1].y - 3.0f * ctrl[2].y + ctrl[3].y;
+    float bx = 3.0f * ctrl[0].x - 6.0f * ctrl[1].x + 3.0f * ctrl[2].x;
+    float by = 3.0f * ctrl[0].y - 6.0f * ctrl[1].y + 3.0f * ctrl[2].y;
+    float cx = 3.0f * (ctrl[1].x - ctrl[0].x);
+    float cy = 3.0f * (ctrl[1].y - ctrl[0].y);
+
+    float fx = ctrl[0].x, fy = ctrl[0].y;
+    float d1x = ax * h3 + bx * h2 + cx * h, d1y = ay * h3 + by * h2 + cy * h;
+    float d2x = 6.0f * ax * h3 + 2.0f * bx * h2, d2y = 6.0f * ay * h3 + 2.0f * by * h2;
+    float d3x = 6.0f * ax * h3, d3y = 6.0f * ay * h3;
+
+    for (int k = 0; k < samples - 1; k++)
+    {
+        if (k >= firstSample)
+        {
+            out[0] = fx;
+            out[1] = fy;
+            out += 2;
+        }
+        fx += d1x;
+        fy += d1y;
+        d1x += d2x;
+        d1y += d2y;
+        d2x += d3x;
+        d2y += d3y;
+    }
+    out[0] = ctrl[3].x;
+    out[1] = ctrl[3].y;
+}
+
+static void sampleCubicForwardDifferenceTable(const point2d ctrl[4], const BernsteinTable &table, int firstSample, float *out)
+{
+    sampleCubicForwardDifference(ctrl, table.samples, firstSample, out);
+}
+
+// Wang's formula: a cubic split into n uniform pieces deviates from its chords by at most
+//     3/4 max(|B0 - 2 B1 + B2|, |B1 - 2 B2 + B3|) / n^2
+// so n = ceil(sqrt(3/4 M / tol)) pieces are enough. This is the same screen-space
+// flatness criterion ImGui's PathBezierToCasteljau applies with CurveTessellationTol,
+// but gives the count up front: no recursion or stack, and the caller can size the
+// output exactly before sampling.
+int adaptiveSampleCount(const point2d ctrl[4], float scaleX, float scaleY, float tol, int maxSamples)
+{
+    float m2 = 0.0f;
+    for (int j = 0; j < 2; j++)
+    {
+        float ddx = (ctrl[j].x - 2.0f * ctrl[j + 1].x + ctrl[j + 2].x) * scaleX;
+        float ddy = (ctrl[j].y - 2.0f * ctrl[j + 1].y + ctrl[j + 2].y) * scaleY;
+        m2 = std::max(m2, ddx * ddx + ddy * ddy);
+    }
+
+    float pieces = std::ceil(std::sqrt(0.75f * std::sqrt(m2) / tol));
+    if (!(pieces < (float)(maxSamples - 1))) // Also catches NaN from a zero tolerance
+        return maxSamples;
+    return std::max(2, (int)pieces + 1);
+}
+
+// The vector samplers evaluate whole blocks of samples (the padding weights are
+// zero) and store only the lanes inside [firstSample, samples). They use separate
+// multiplies and adds in the same order as the scalar loop, so all levels give
+// bit-identical results.
+#if TESSELLATE_X86_DISPATCH
+// Copy the interleaved (x, y) pairs of lanes lo..hi-1 to out
+static inline float *storeSamplePairs(const float *xy, int lo, int hi, float *out)
+{
+    memcpy(out, xy + 2 * lo, 2 * (hi - lo) * sizeof(float));
+    return out + 2 * (hi - lo);
+}
+
+__attribute__((target("sse2"))) static void sampleCubicSSE2(const point2d ctrl[4], const BernsteinTable &table, int firstSample, float *out)
+{
+    __m128 px[4], py[4];
+    for (int j = 0; j < 4; j++)
+    {
+        px[j] = _mm_set1_ps(ctrl[j].x);
+        py[j] = _mm_set1_ps(ctrl[j].y);
+    }
+
+    alignas(16) float xy[8];
+    for (int block = firstSample & ~3; block < table.samples; block += 4)
+    {
+        __m128 w0 = _mm_loadu_ps(&table.w[0][block]), w1 = _mm_loadu_ps(&table.w[1][block]);
+        __m128 w2 = _mm_loadu_ps(&table.w[2][block]), w3 = _mm_loadu_ps(&table.w[3][block]);
+        __m128 vx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, px[0]), _mm_mul_ps(w1, px[1])), _mm_mul_ps(w2, px[2])), _mm_mul_ps(w3, px[3]));
+        __m128 vy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, py[0]), _mm_mul_ps(w1, py[1])), _mm_mul_ps(w2, py[2])), _mm_mul_ps(w3, py[3]));
+        _mm_store_ps(xy, _mm_unpacklo_ps(vx, vy));
+        _mm_store_ps(xy + 4, _mm_unpackhi_ps(vx, vy));
+
+        int first = block < firstSample ? firstSample - block : 0;
+        int last = block + 4 < table.samples ? 4 : table.samples - block;
+        out = storeSamplePairs(xy, first, last, out);
+    }
+}
+
+__attribute__((target("avx2"))) static void sampleCubicAVX2(const point2d ctrl[4], const BernsteinTable &table, int firstSample, float *out)
+{
+    __m256 px[4], py[4];
+    for (int j = 0; j < 4; j++)
+    {
+        px[j] = _mm256_set1_ps(ctrl[j].x);
+        py[j] = _mm256_set1_ps(ctrl[j].y);
+    }
+
+    alignas(32) float xy[16];
+    for (int block = firstSample & ~7; block < table.samples; block += 8)
+    {
+        __m256 w0 = _mm256_loadu_ps(&table.w[0][block]), w1 = _mm256_loadu_ps(&table.w[1][block]);
+        __m256 w2 = _mm256_loadu_ps(&table.w[2][block]), w3 = _mm256_loadu_ps(&table.w[3][block]);
+        __m256 vx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, px[0]), _mm256_mul_ps(w1, px[1])), _mm256_mul_ps(w2, px[2])), _mm256_mul_ps(w3, px[3]));
+        __m256 vy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, py[0]), _mm256_mul_ps(w1, py[1])), _mm256_mul_ps(w2, py[2])), _mm256_mul_ps(w3, py[3]));
+
+        // unpack works within 128-bit halves; permute the halves back into sample order
+        __m256 lo = _mm256_unpacklo_ps(vx, vy), hi = _mm256_unpackhi_ps(vx, vy);
+        _mm256_store_ps(xy, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_store_ps(xy + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+
+        int first = block < firstSample ? firstSample - block : 0;
+        int last = block + 8 < table.samples ? 8 : table.samples - block;
+        out = storeSamplePairs(xy, first, last, out);
+    }
+}
+#endif
+
+SimdLevel detectSimdLevel()
+{
+#if TESSELLATE_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_AVX2:
+        return "AVX2";
+    case SIMD_SSE2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+CubicSampler getCubicSampler(SimdLevel level)
+{
+    SimdLevel supported = detectSimdLevel();
+    if (level > supported)
+        level = supported;
+
+#if TESSELLATE_X86_DISPATCH
+    if (level == SIMD_AVX2)
+        return sampleCubicAVX2;
+    if (level == SIMD_SSE2)
+        return sampleCubicSSE2;
+#endif
+    return sampleCubicScalar;
+}
+
+CubicSampler getCubicSampler()
+{
+    static CubicSampler best = getCubicSampler(detectSimdLevel());
+    return best;
+}
+
+// Sample counts with a compile-time specialized sampler, picked at runtime by count
+static const struct
+{
+    int samples;
+    CubicSampler sampler;
+} fixedCubicSamplers[] = {
+    {4, Tessellator<3, 4>::sampleCubic},
+    {8, Tessellator<3, 8>::sampleCubic},
+    {10, Tessellator<3, 10>::sampleCubic},
+    {16, Tessellator<3, 16>::sampleCubic},
+    {32, Tessellator<3, 32>::sampleCubic},
+    {64, Tessellator<3, 64>::sampleCubic},
+};
+
+CubicSampler getFixedCubicSampler(int samples)
+{
+    for (const auto &entry : fixedCubicSamplers)
+    {
+        if (entry.samples == samples)
+            return entry.sampler;
+    }
+    return NULL;
+}
+
+CubicSampler getTessellationSampler(TessellationMode mode)
+{
+    if (mode == TESSELLATE_FORWARD_DIFFERENCE)
+        return sampleCubicForwardDifferenceTable;
+    return getCubicSampler();
+}
+
+CubicSampler getTessellationSampler(TessellationMode mode, int samples)
+{
+    CubicSampler fixed = getFixedCubicSampler(samples);
+    if (mode == TESSELLATE_DIRECT && fixed)
+        return fixed;
+    return getTessellationSampler(mode);
+}
+
+const char *tessellationModeName(TessellationMode mode)
+{
+    switch (mode)
+    {
+    case TESSELLATE_FORWARD_DIFFERENCE:
+        return "Forward differences";
+    case TESSELLATE_ADAPTIVE:
+        return "Adaptive (flatness)";
+    default:
+        return "Direct (Bernstein)";
+    }
+}
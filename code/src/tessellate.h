@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+
+struct point2d
+{
+    float x, y;
+};
+
+// Bernstein weights b0..b3 of a cubic at `samples` uniformly spaced t in [0, 1].
+// Each weight array is zero-padded to a multiple of 8 so that the SIMD samplers
+// can always process whole vectors.
+struct BernsteinTable
+{
+    int samples = 0;
+    std::vector<float> w[4];
+};
+
+void buildBernsteinTable(BernsteinTable &table, int samples);
+
+enum SimdLevel
+{
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+SimdLevel detectSimdLevel();
+const char *simdLevelName(SimdLevel level);
+
+// Evaluate samples firstSample..table.samples-1 of the cubic with control points
+// ctrl[0..3] and write them to out as consecutive (x, y) pairs.
+typedef void (*CubicSampler)(const point2d ctrl[4], const BernsteinTable &table, int firstSample, float *out);
+
+// Walks the cubic with third-order forward differences: three adds per
+// coordinate per sample instead of a full Bernstein evaluation. Needs no weight
+// table, so any sample count works; see tessellate.cpp for its error bound.
+void sampleCubicForwardDifference(const point2d ctrl[4], int samples, int firstSample, float *out);
+
+// Smallest number of uniform samples for which the polyline through them stays
+// within tol of the cubic, with control points scaled by (scaleX, scaleY) into
+// the space tol is measured in (e.g. NDC to pixels). Clamped to [2, maxSamples].
+int adaptiveSampleCount(const point2d ctrl[4], float scaleX, float scaleY, float tol, int maxSamples);
+
+// Sampler for the given level; falls back to the best level this CPU supports.
+CubicSampler getCubicSampler(SimdLevel level);
+CubicSampler getCubicSampler();
+
+// Compile-time specialized sampler (see tessellator.h) for tables of exactly
+// `samples` samples, or NULL if that count has no specialization.
+CubicSampler getFixedCubicSampler(int samples);
+
+enum TessellationMode
+{
+    TESSELLATE_DIRECT,            // Bernstein evaluation per sample, SIMD dispatched
+    TESSELLATE_FORWARD_DIFFERENCE, // Incremental evaluation with forward differences
+    TESSELLATE_ADAPTIVE            // Per-segment sample count from a flatness tolerance
+};
+
+// Sampler for the fixed-count modes; TESSELLATE_ADAPTIVE samples through
+// adaptiveSampleCount() and sampleCubicForwardDifference() instead.
+CubicSampler getTessellationSampler(TessellationMode mode);
+// As above, preferring a fixed-count specialization for tables of `samples` samples
+CubicSampler getTessellationSampler(TessellationMode mode, int samples);
+const char *tessellationModeName(TessellationMode mode);
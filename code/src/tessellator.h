@@ -0,0 +1,103 @@
+#pragma once
+#include "tessellate.h"
+
+// Bezier segment evaluator specialized on the degree and the sample count.
+// The basis weights are computed at compile time and both loops have constant
+// bounds, so each segment turns into a fixed (Samples x Degree+1) by
+// (Degree+1 x 2) matrix multiply with no table lookups through pointers.
+// tessellate.cpp instantiates the common cubic sample counts and picks one at
+// runtime with getFixedCubicSampler().
+//
+// Weights and sums are evaluated in the same order as buildBernsteinTable()
+// and the scalar sampler, so a cubic Tessellator produces bit-identical output.
+
+#if defined(__clang__)
+#define TESSELLATOR_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define TESSELLATOR_UNROLL _Pragma("GCC unroll 64")
+#else
+#define TESSELLATOR_UNROLL
+#endif
+
+constexpr float binomialCoefficient(int n, int k)
+{
+    float c = 1.0f;
+    for (int i = 1; i <= k; i++)
+        c = c * (n - k + i) / i;
+    return c;
+}
+
+template <int Degree, int Samples>
+struct Tessellator
+{
+    static_assert(Degree >= 1, "Tessellator needs at least a line segment");
+    static_assert(Samples >= 2, "Tessellator needs both end points");
+
+    // Stored per basis function so that each row is a contiguous vector over the samples
+    struct Weights
+    {
+        float w[Degree + 1][Samples];
+    };
+
+    // w[j][k] = C(Degree, j) (1 - t)^(Degree - j) t^j at t = k / (Samples - 1)
+    static constexpr Weights makeWeights()
+    {
+        Weights table = {};
+        float interval = 1.0f / (Samples - 1);
+        for (int k = 0; k < Samples; k++)
+        {
+            float t = k * interval;
+            float v = 1.0f - t;
+            for (int j = 0; j <= Degree; j++)
+            {
+                float w = binomialCoefficient(Degree, j);
+                for (int i = 0; i < Degree - j; i++)
+                    w = w * v;
+                for (int i = 0; i < j; i++)
+                    w = w * t;
+                table.w[j][k] = w;
+            }
+        }
+        return table;
+    }
+
+    static constexpr Weights weights = makeWeights();
+
+    // Evaluates all samples into separate x and y rows (which the compiler can
+    // vectorize), then interleaves samples firstSample..Samples-1 as (x, y) pairs.
+    static void sample(const point2d ctrl[Degree + 1], int firstSample, float *out)
+    {
+        float x[Samples], y[Samples];
+        TESSELLATOR_UNROLL
+        for (int k = 0; k < Samples; k++)
+        {
+            x[k] = weights.w[0][k] * ctrl[0].x;
+            y[k] = weights.w[0][k] * ctrl[0].y;
+        }
+        TESSELLATOR_UNROLL
+        for (int j = 1; j <= Degree; j++)
+        {
+            TESSELLATOR_UNROLL
+            for (int k = 0; k < Samples; k++)
+            {
+                x[k] += weights.w[j][k] * ctrl[j].x;
+                y[k] += weights.w[j][k] * ctrl[j].y;
+            }
+        }
+        for (int k = firstSample; k < Samples; k++, out += 2)
+        {
+            out[0] = x[k];
+            out[1] = y[k];
+        }
+    }
+
+    // Matches the CubicSampler signature; the table is not consulted
+    static void sampleCubic(const point2d ctrl[4], const BernsteinTable &, int firstSample, float *out)
+    {
+        static_assert(Degree == 3, "sampleCubic is only defined for cubic Tessellators");
+        sample(ctrl, firstSample, out);
+    }
+};
+
+template <int Degree, int Samples>
+constexpr typename Tessellator<Degree, Samples>::Weights Tessellator<Degree, Samples>::weights;
@@ -0,0 +1,141 @@
+#include "threadpool.h"
+#include "trace.h"
+#include <algorithm>
+
+static unsigned requestedPoolSize = 0;
+
+ThreadPool::ThreadPool(unsigned threads) : runs(std::max(1u, threads))
+{
+    for (unsigned i = 0; i + 1 < runs.size(); i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::run(int begin, int end, int grain, ChunkFunction function, void *ctx)
+{
+    if (begin >= end)
+        return;
+    grain = std::max(1, grain);
+    int chunks = (end - begin + grain - 1) / grain;
+    unsigned participants = runs.size();
+    if (chunks == 1 || participants == 1)
+    {
+        function(ctx, begin, end);
+        return;
+    }
+
+    unsigned current;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = ++generation;
+        this->function = function;
+        this->ctx = ctx;
+        this->begin = begin;
+        this->end = end;
+        this->grain = grain;
+        remaining.store(chunks);
+
+        for (unsigned p = 0; p < participants; p++)
+        {
+            std::lock_guard<std::mutex> runLock(runs[p].mutex);
+            runs[p].generation = current;
+            runs[p].first = (int)((long long)chunks * p / participants);
+            runs[p].last = (int)((long long)chunks * (p + 1) / participants);
+        }
+    }
+    wake.notify_all();
+
+    work(participants - 1, current);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]
+              { return remaining.load() == 0; });
+}
+
+bool ThreadPool::takeChunk(unsigned runIndex, unsigned generation, bool steal, int &chunk)
+{
+    ChunkRun &run = runs[runIndex];
+    std::lock_guard<std::mutex> lock(run.mutex);
+    if (run.generation != generation || run.first >= run.last)
+        return false;
+    chunk = steal ? --run.last : run.first++;
+    return true;
+}
+
+// Run chunks of the given generation until none are left anywhere
+void ThreadPool::work(unsigned self, unsigned generation)
+{
+    ChunkFunction function;
+    void *ctx;
+    int begin, end, grain;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (generation != this->generation)
+            return;
+        function = this->function;
+        ctx = this->ctx;
+        begin = this->begin;
+        end = this->end;
+        grain = this->grain;
+    }
+
+    unsigned participants = runs.size();
+    for (unsigned victim = self, tried = 0; tried < participants;)
+    {
+        int chunk;
+        if (!takeChunk(victim, generation, victim != self, chunk))
+        {
+            victim = (victim + 1) % participants;
+            tried++;
+            continue;
+        }
+
+        int lo = begin + chunk * grain;
+        function(ctx, lo, std::min(end, lo + grain));
+        if (remaining.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+        tried = 0; // Found work: rescan everyone before giving up
+    }
+}
+
+void ThreadPool::workerLoop(unsigned self)
+{
+    TRACE_THREAD_NAME("pool worker");
+    unsigned seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]
+                      { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        work(self, seen);
+    }
+}
+
+ThreadPool &globalThreadPool()
+{
+    static ThreadPool pool(requestedPoolSize ? requestedPoolSize : std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void setThreadPoolSize(unsigned threads)
+{
+    requestedPoolSize = threads;
+}
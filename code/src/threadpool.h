@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads for data-parallel loops. A parallelFor()
+// splits [begin, end) into chunks and deals each participant (the workers and
+// the calling thread) a contiguous run of them. Participants take chunks from
+// the front of their own run and, once it is empty, steal from the back of
+// the others' runs. Dispatching a loop never allocates.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    // Total number of threads working on a loop, including the caller
+    unsigned size() const { return workers.size() + 1; }
+
+    // Call f(lo, hi) over [begin, end) in chunks of about grain indices and wait
+    // for all of them. Must not be called from inside f.
+    template <typename F>
+    void parallelFor(int begin, int end, int grain, F &&f)
+    {
+        run(begin, end, grain, [](void *ctx, int lo, int hi)
+            { (*(F *)ctx)(lo, hi); },
+            (void *)&f);
+    }
+
+private:
+    typedef void (*ChunkFunction)(void *ctx, int lo, int hi);
+
+    struct alignas(64) ChunkRun // Own cache line: owners and thieves lock these concurrently
+    {
+        std::mutex mutex;
+        unsigned generation = 0;
+        int first = 0, last = 0; // Chunks [first, last) not yet taken
+    };
+
+    void run(int begin, int end, int grain, ChunkFunction function, void *ctx);
+    void work(unsigned self, unsigned generation);
+    bool takeChunk(unsigned runIndex, unsigned generation, bool steal, int &chunk);
+    void workerLoop(unsigned self);
+
+    std::vector<std::thread> workers;
+    std::vector<ChunkRun> runs; // One per participant; the caller uses the last one
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    bool stopping = false;
+    unsigned generation = 0;
+
+    // The loop being run, valid for chunks of the current generation
+    ChunkFunction function = nullptr;
+    void *ctx = nullptr;
+    int begin = 0, end = 0, grain = 1;
+    std::atomic<int> remaining{0};
+};
+
+// Shared pool, created on first use with setThreadPoolSize() threads
+// (0, the default, means one per hardware thread).
+ThreadPool &globalThreadPool();
+void setThreadPoolSize(unsigned threads);
@@ -0,0 +1,119 @@
+#include "trace.h"
+
+#if CURVE_TRACE
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <vector>
+
+struct TraceEvent
+{
+    const char *name;
+    uint64_t start, duration; // Nanoseconds since traceEpoch
+};
+
+// Single-producer ring: only the owning thread writes, a dump may read concurrently
+struct TraceRing
+{
+    TraceEvent events[traceRingCapacity];
+    std::atomic<uint64_t> written{0}; // Zones ever recorded; slot of zone n is n % traceRingCapacity
+    std::atomic<const char *> threadName{nullptr};
+    int tid = 0;
+};
+
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+static std::mutex traceRingsMutex;
+static std::vector<TraceRing *> traceRings; // Never freed, so zones of finished threads can still be dumped
+
+static uint64_t traceNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+// The calling thread's ring, registered on its first zone
+static TraceRing &threadRing()
+{
+    thread_local TraceRing *ring = nullptr;
+    if (!ring)
+    {
+        ring = new TraceRing();
+        std::lock_guard<std::mutex> lock(traceRingsMutex);
+        ring->tid = (int)traceRings.size() + 1;
+        traceRings.push_back(ring);
+    }
+    return *ring;
+}
+
+TraceZone::TraceZone(const char *zoneName) : name(zoneName), start(traceNow())
+{
+}
+
+TraceZone::~TraceZone()
+{
+    TraceRing &ring = threadRing();
+    uint64_t n = ring.written.load(std::memory_order_relaxed);
+    ring.events[n % traceRingCapacity] = {name, start, traceNow() - start};
+    ring.written.store(n + 1, std::memory_order_release);
+}
+
+void traceSetThreadName(const char *name)
+{
+    threadRing().threadName.store(name, std::memory_order_relaxed);
+}
+
+// Copy the zones of ring that are not being overwritten while we read them
+static void snapshotRing(const TraceRing &ring, std::vector<TraceEvent> &events)
+{
+    events.clear();
+    uint64_t end = ring.written.load(std::memory_order_acquire);
+    uint64_t begin = end > (uint64_t)traceRingCapacity ? end - traceRingCapacity : 0;
+    for (uint64_t i = begin; i < end; i++)
+        events.push_back(ring.events[i % traceRingCapacity]);
+
+    // Zone n overwrites the slot of zone n - capacity, so anything at or below
+    // (written now - capacity) may have been torn while copying.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t writtenNow = ring.written.load(std::memory_order_relaxed);
+    uint64_t firstIntact = writtenNow >= (uint64_t)traceRingCapacity ? writtenNow - traceRingCapacity + 1 : 0;
+    if (firstIntact > begin)
+        events.erase(events.begin(), events.begin() + std::min<uint64_t>(firstIntact - begin, events.size()));
+}
+
+bool traceWriteJson(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        perror(path);
+        return false;
+    }
+
+    std::vector<TraceRing *> rings;
+    {
+        std::lock_guard<std::mutex> lock(traceRingsMutex);
+        rings = traceRings;
+    }
+
+    // Zone names are string literals from TRACE_ZONE, so they need no escaping
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    std::vector<TraceEvent> events;
+    for (const TraceRing *ring : rings)
+    {
+        const char *threadName = ring->threadName.load(std::memory_order_relaxed);
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", ring->tid, threadName ? threadName : "thread");
+        first = false;
+
+        snapshotRing(*ring, events);
+        for (const TraceEvent &event : events)
+        {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, ring->tid, event.start * 1e-3, event.duration * 1e-3);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+#endif
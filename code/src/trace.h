@@ -0,0 +1,50 @@
+#pragma once
+
+// Scoped trace zones, exported as Chrome trace_event JSON (chrome://tracing or Perfetto).
+// Configure with -DCURVE_TRACE=ON to record them; otherwise every macro below
+// expands to nothing and no tracing code is compiled in.
+//
+//   void calculateSomething()
+//   {
+//       TRACE_ZONE("calculateSomething");
+//       ...
+//   }
+//
+// Each thread records into its own fixed-size ring buffer without locking. Once
+// a ring is full the oldest zones are overwritten, so a dump holds the most
+// recent traceRingCapacity zones of every thread.
+#if CURVE_TRACE
+#include <stdint.h>
+
+static const int traceRingCapacity = 1 << 16; // Zones kept per thread
+
+struct TraceZone
+{
+    const char *name;
+    uint64_t start;
+
+    explicit TraceZone(const char *zoneName);
+    ~TraceZone();
+};
+
+// Names the calling thread in the trace. name must outlive the process (a literal).
+void traceSetThreadName(const char *name);
+// Writes every thread's recorded zones; safe to call while other threads keep recording.
+bool traceWriteJson(const char *path);
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) traceSetThreadName(name)
+#define TRACE_WRITE_JSON(path) traceWriteJson(path)
+#else
+#define TRACE_ZONE(name) \
+    do                   \
+    {                    \
+    } while (0)
+#define TRACE_THREAD_NAME(name) \
+    do                          \
+    {                           \
+    } while (0)
+#define TRACE_WRITE_JSON(path) false
+#endif
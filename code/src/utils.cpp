@@ -1,88 +1,78 @@
 #include "utils.h"
+#include "curve.h"
+#include "fontcache.h"
+#include "pointgrid.h"
+#include "programcache.h"
+#include "startup.h"
+#include "trace.h"
+#include <algorithm>
 #include <vector> // Make sure this is included
 
 // Add this declaration
-extern std::vector<float> tangentLines;
 extern bool controlPointsUpdated;
 extern bool controlPointsFinished;
 extern int selectedControlPoint;
+extern int redrawFramesPending;
+extern bool overlapStartup;
 
-float selectionThreshold = 3.0f;     // Select any control point within 3 pixels of vicinity.
-std::vector<float> rawControlPoints; // Screen-space positions of control-points
+float selectionThreshold = 3.0f; // Select any control point within 3 pixels of vicinity.
+PointGrid controlPointGrid;      // Spatial index over the control points (window pixels), for picking
 
 void cleanup(GLFWwindow *window)
 {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
+    ImFontAtlas *fonts = ImGui::GetIO().Fonts; // Built by setupWindow, not owned by the context
     ImGui::DestroyContext();
+    IM_DELETE(fonts);
 
     glfwDestroyWindow(window);
     glfwTerminate();
 }
 
-void clearLines(std::vector<float> &points)
+void clearLines(CurveDocument &doc)
 {
-    points.clear();
+    curveDocumentClear(doc);
     controlPointsUpdated = true;
 }
 
-void addControlPoint(std::vector<float> &points, float x, float y, int w, int h)
+void addControlPoint(CurveDocument &doc, float x, float y, int w, int h)
 {
-    float rescaled_x = -1.0 + ((1.0 * x - 0) / (w - 0)) * (1.0 - (-1.0));
-    float rescaled_y = -1.0 + ((1.0 * (h - y) - 0) / (h - 0)) * (1.0 - (-1.0));
-    points.push_back(rescaled_x);
-    points.push_back(rescaled_y);
-    points.push_back(0.0); // Z-coordinate
-
-    rawControlPoints.push_back(x);
-    rawControlPoints.push_back(y);
+    TRACE_ZONE("addControlPoint");
+    int index = curveDocumentAdd(doc, x, y); // The document is in window pixels, like the mouse
+
+    // Cells one selection radius wide over the window: a pick then visits at most 3x3 cells
+    if (controlPointGrid.head.empty())
+        pointGridInit(controlPointGrid, selectionThreshold, w, h);
+    pointGridInsert(controlPointGrid, index, x, y);
 }
 
 // Search nearest control point to (x, y) and set its index to
 // selectedControlPoint (return true), else -1 (return false)
 bool searchNearestControlPoint(float x, float y)
 {
-    size_t npts = rawControlPoints.size() / 2;
-    if (npts > 0)
-    {
-        float _x, _y, dist2 = 0.0f;
-        float thresh2 = selectionThreshold * selectionThreshold;
-        for (size_t i = 0; i < npts; i++)
-        {
-            _x = rawControlPoints[2 * i];
-            _y = rawControlPoints[2 * i + 1];
-            dist2 = (x - _x) * (x - _x) + (y - _y) * (y - _y);
-            if (dist2 <= thresh2)
-            {
-                selectedControlPoint = i;
-                return 1;
-            }
-        }
-    }
-
-    selectedControlPoint = -1;
-    return 0;
+    TRACE_ZONE("searchNearestControlPoint");
+    selectedControlPoint = pointGridNearest(controlPointGrid, curveDocument.x.data(), curveDocument.y.data(), x, y,
+                                            selectionThreshold);
+    return selectedControlPoint >= 0;
 }
 
-void editControlPoint(std::vector<float> &points, float x, float y, int w, int h)
+void editControlPoint(CurveDocument &doc, float x, float y)
 {
+    TRACE_ZONE("editControlPoint");
     if (selectedControlPoint < 0)
         return;
-    if (selectedControlPoint >= points.size() / 3)
+    if (selectedControlPoint >= curveDocumentSize(doc))
         return;
 
-    float rescaled_x = -1.0 + ((1.0 * x - 0) / (w - 0)) * (1.0 - (-1.0));
-    float rescaled_y = -1.0 + ((1.0 * (h - y) - 0) / (h - 0)) * (1.0 - (-1.0));
-    points[selectedControlPoint * 3] = rescaled_x;
-    points[selectedControlPoint * 3 + 1] = rescaled_y;
-    points[selectedControlPoint * 3 + 2] = 0.0; // Z-coordinate
-
-    rawControlPoints[selectedControlPoint * 2] = x;
-    rawControlPoints[selectedControlPoint * 2 + 1] = y;
+    curveDocumentMove(doc, selectedControlPoint, x, y);
+    pointGridMove(controlPointGrid, selectedControlPoint, x, y);
+    markControlPointDirty(selectedControlPoint);
 }
 
-void showOptionsDialog(std::vector<float> &points, ImGuiIO &io)
+void showOptionsDialog(CurveDocument &doc, ImGuiIO &io)
 {
+    TRACE_ZONE("showOptionsDialog");
     ImGui::Begin("Toolbox", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
     ImGui::Text("Mouse Left Click: add/select control points");
     ImGui::Text("Mouse Right Click: switch mode from \'Add\' to \'Select\'");
@@ -92,9 +82,9 @@ void showOptionsDialog(std::vector<float> &points, ImGuiIO &io)
     if (ImGui::Button("Clear"))
     {
         // Clear points
-        clearLines(points);
+        clearLines(doc);
         tangentLines.clear();
-        rawControlPoints.clear();
+        pointGridClear(controlPointGrid);
         controlPointsFinished = false;
         selectedControlPoint = -1; // Deselect
     }
@@ -105,37 +95,10 @@ void showOptionsDialog(std::vector<float> &points, ImGuiIO &io)
 void setVAO(unsigned int &VAO)
 {
     glBindVertexArray(VAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
     glEnableVertexAttribArray(0);
 }
 
-GLuint createShader(const char *filename, GLenum type)
-{
-    const GLchar *source = getShaderCode(filename);
-    if (source == NULL)
-    {
-        fprintf(stderr, "Error opening %s: ", filename);
-        perror("");
-        return 0;
-    }
-    GLuint res = glCreateShader(type);
-    glShaderSource(res, 1, &source, NULL);
-    free((void *)source);
-
-    glCompileShader(res);
-    GLint compile_ok = GL_FALSE;
-    glGetShaderiv(res, GL_COMPILE_STATUS, &compile_ok);
-    if (compile_ok == GL_FALSE)
-    {
-        // fprintf(stderr, "%s:", filename);
-        std::cout << "Error in compilation of :" << filename << std::endl;
-        glDeleteShader(res);
-        return 0;
-    }
-
-    return res;
-}
-
 const char *setGLSLVersion()
 {
 #if __APPLE__
@@ -201,104 +164,163 @@ int openGLInit()
     return 1;
 }
 
-unsigned int createProgram(const char *vshader_filename, const char *fshader_filename)
+static void glfw_error_callback(int error, const char *description)
 {
-    // Create shader objects
-    GLuint vs, fs;
-    if ((vs = createShader(vshader_filename, GL_VERTEX_SHADER)) == 0)
-        return 0;
-    if ((fs = createShader(fshader_filename, GL_FRAGMENT_SHADER)) == 0)
-        return 0;
-
-    // Creare program object and link shader objects
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-    GLint link_ok;
-    glGetProgramiv(program, GL_LINK_STATUS, &link_ok);
-    if (!link_ok)
-    {
-        // fprintf(stderr, "glLinkProgram error:");
-        // printLog(program);
-        std::cout << "Linking error " << std::endl;
-        glDeleteShader(vs);
-        glDeleteShader(fs);
-        glDeleteProgram(program);
-        return 0;
-    }
-    return program;
+    fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-char *getShaderCode(const char *filename)
+// Input wakes the idle display loop. ImGui only sees mouse motion, hover and
+// release on the frames after the event, so keep drawing a few frames.
+static const int redrawFramesAfterEvent = 3;
+
+static GLFWmousebuttonfun imguiMouseButtonCallback = NULL;
+static GLFWscrollfun imguiScrollCallback = NULL;
+static GLFWkeyfun imguiKeyCallback = NULL;
+static GLFWcharfun imguiCharCallback = NULL;
+
+void requestRedraw()
 {
-    FILE *input = fopen(filename, "rb");
-    if (input == NULL)
-        return NULL;
-
-    if (fseek(input, 0, SEEK_END) == -1)
-        return NULL;
-    long size = ftell(input);
-    if (size == -1)
-        return NULL;
-    if (fseek(input, 0, SEEK_SET) == -1)
-        return NULL;
-
-    /*if using c-compiler: dont cast malloc's return value*/
-    char *content = (char *)malloc((size_t)size + 1);
-    if (content == NULL)
-        return NULL;
-
-    fread(content, 1, (size_t)size, input);
-    if (ferror(input))
-    {
-        free(content);
-        return NULL;
-    }
+    redrawFramesPending = redrawFramesAfterEvent;
+}
 
-    fclose(input);
-    content[size] = '\0';
-    return content;
+static void redrawMouseButtonCallback(GLFWwindow *window, int button, int action, int mods)
+{
+    if (imguiMouseButtonCallback)
+        imguiMouseButtonCallback(window, button, action, mods);
+    requestRedraw();
 }
 
-static void glfw_error_callback(int error, const char *description)
+static void redrawScrollCallback(GLFWwindow *window, double xoffset, double yoffset)
 {
-    fprintf(stderr, "Glfw Error %d: %s\n", error, description);
+    if (imguiScrollCallback)
+        imguiScrollCallback(window, xoffset, yoffset);
+    requestRedraw();
+}
+
+static void redrawKeyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    if (imguiKeyCallback)
+        imguiKeyCallback(window, key, scancode, action, mods);
+    requestRedraw();
+}
+
+static void redrawCharCallback(GLFWwindow *window, unsigned int c)
+{
+    if (imguiCharCallback)
+        imguiCharCallback(window, c);
+    requestRedraw();
+}
+
+static void redrawCursorPosCallback(GLFWwindow *, double, double) { requestRedraw(); }
+static void redrawCursorEnterCallback(GLFWwindow *, int) { requestRedraw(); }
+static void redrawFocusCallback(GLFWwindow *, int) { requestRedraw(); }
+static void redrawFramebufferSizeCallback(GLFWwindow *, int, int) { requestRedraw(); }
+static void redrawRefreshCallback(GLFWwindow *) { requestRedraw(); }
+
+// Must run after ImGui_ImplGlfw_InitForOpenGL so ImGui's callbacks are chained, not replaced.
+void installRedrawCallbacks(GLFWwindow *window)
+{
+    imguiMouseButtonCallback = glfwSetMouseButtonCallback(window, redrawMouseButtonCallback);
+    imguiScrollCallback = glfwSetScrollCallback(window, redrawScrollCallback);
+    imguiKeyCallback = glfwSetKeyCallback(window, redrawKeyCallback);
+    imguiCharCallback = glfwSetCharCallback(window, redrawCharCallback);
+    glfwSetCursorPosCallback(window, redrawCursorPosCallback);
+    glfwSetCursorEnterCallback(window, redrawCursorEnterCallback);
+    glfwSetWindowFocusCallback(window, redrawFocusCallback);
+    glfwSetFramebufferSizeCallback(window, redrawFramebufferSizeCallback);
+    glfwSetWindowRefreshCallback(window, redrawRefreshCallback);
+    requestRedraw();
+}
+
+int displayRefreshRate()
+{
+    GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode *mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    return (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+}
+
+static GLuint startupPrograms[EDITOR_PROGRAM_COUNT];
+static bool startupProgramsDone = false;
+
+static void waitForStartupPrograms()
+{
+    if (startupProgramsDone)
+        return;
+    double phase = startupElapsedMs();
+    finishEditorPrograms(startupPrograms);
+    startupRecord("wait for programs", phase);
+    startupProgramsDone = true;
 }
 
 GLFWwindow *setupWindow(int width, int height)
 {
+    TRACE_ZONE("setupWindow");
+    // The font atlas and imgui.ini only need the CPU: get them while the window opens
+    startFontAtlasBuild(NULL, "imgui.ini", overlapStartup);
+
     // Setup window
+    double phase = startupElapsedMs();
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
         exit(0);
+    startupRecord("glfwInit", phase);
 
     // Decide GL+GLSL versions
     const char *glsl_version = setGLSLVersion();
 
     // Create window with graphics context
+    phase = startupElapsedMs();
     glfwWindowHint(GLFW_SAMPLES, 4);
     GLFWwindow *window = glfwCreateWindow(width, height, "Assignment 01: Piecewise interpolating Bezier curve", NULL, NULL);
     if (window == NULL)
         exit(0);
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1); // Enable vsync
+    startupRecord("window and context", phase);
 
     // Initialize OpenGL loader
+    phase = startupElapsedMs();
     int status = openGLInit();
     if (!status)
     {
         std::cout << "Initialized OpenGL succesfully " << std::endl;
     }
     std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+    programCacheInit();
+    startupRecord("OpenGL loader", phase);
+
+    // Compiling the programs is the longest phase with a cold program cache: issue them
+    // now and only wait for them once ImGui has started up
+    phase = startupElapsedMs();
+    startEditorPrograms();
+    startupRecord("start programs", phase);
+    if (!overlapStartup)
+        waitForStartupPrograms();
 
     // Setup Dear ImGui context
+    phase = startupElapsedMs();
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-
+    std::string iniData;
+    ImGui::CreateContext(finishFontAtlasBuild(&iniData));
+    if (!iniData.empty())
+        ImGui::LoadIniSettingsFromMemory(iniData.data(), iniData.size()); // Else the first NewFrame reads imgui.ini
     ImGui::StyleColorsDark();
+    startupRecord("ImGui context", phase);
+
+    // Compile ImGui's program and upload the font texture now rather than in the first
+    // frame, while the driver builds the editor's programs
+    phase = startupElapsedMs();
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
+    ImGui_ImplOpenGL3_CreateDeviceObjects();
+    installRedrawCallbacks(window);
+    startupRecord("ImGui backends", phase);
 
     return window;
 }
+
+void finishStartupPrograms(GLuint programs[EDITOR_PROGRAM_COUNT])
+{
+    waitForStartupPrograms();
+    std::copy(startupPrograms, startupPrograms + EDITOR_PROGRAM_COUNT, programs);
+}
@@ -4,31 +4,9 @@
 #include <stdio.h>
 #include <iostream>
 #include <vector>
-// About Desktop OpenGL function loaders:
-//  Modern desktop OpenGL doesn't have a standard portable header file to load OpenGL function pointers.
-//  Helper libraries are often used for this purpose! Here we are supporting a few common ones (gl3w, glew, glad).
-//  You may use another loader/header of your choice (glext, glLoadGen, etc.), or chose to manually implement your own.
-#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
-#include <GL/gl3w.h>            // Initialize with gl3wInit()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
-#include <GL/glew.h>            // Initialize with glewInit()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
-#include <glad/glad.h>          // Initialize with gladLoadGL()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD2)
-#include <glad/gl.h>            // Initialize with gladLoadGL(...) or gladLoaderLoadGL()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
-#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
-#include <glbinding/Binding.h>  // Initialize with glbinding::Binding::initialize()
-#include <glbinding/gl/gl.h>
-using namespace gl;
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
-#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
-#include <glbinding/glbinding.h>// Initialize with glbinding::initialize()
-#include <glbinding/gl/gl.h>
-using namespace gl;
-#else
-#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
-#endif
+#include "glloader.h"
+#include "shaderprogram.h"
+#include "curvedocument.h"
 
 // Include glfw3.h after our OpenGL definitions
 #include <GLFW/glfw3.h>
@@ -43,16 +21,18 @@ using namespace gl;
 int openGLInit();
    
 const char * setGLSLVersion();
-GLuint createShader(const char* filename, GLenum type);
-unsigned int createProgram(const char *vshader_filename, const char* fshader_filename);
-char * getShaderCode(const char*);
 
 void cleanup(GLFWwindow* );
-void addControlPoint(std::vector<float> &points, float , float , int , int );
-void editControlPoint(std::vector<float> &points, float , float , int , int );
-void clearLines(std::vector<float> &points);
+void addControlPoint(CurveDocument &doc, float , float , int , int );
+void editControlPoint(CurveDocument &doc, float , float );
+void clearLines(CurveDocument &doc);
 bool searchNearestControlPoint(float x, float y);
-void showOptionsDialog(std::vector<float> &points, ImGuiIO &io); 
+void showOptionsDialog(CurveDocument &doc, ImGuiIO &io); 
+// Also starts building the editor's programs; wait for them with finishStartupPrograms()
 GLFWwindow* setupWindow(int, int);
+void finishStartupPrograms(GLuint programs[EDITOR_PROGRAM_COUNT]);
+void installRedrawCallbacks(GLFWwindow *);
+void requestRedraw();
+int displayRefreshRate();
 
 void setVAO(unsigned int &);
@@ -0,0 +1,195 @@
+#include "vertexformat.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+const char *vertexFormatName(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_FLOAT16:
+        return "2x float16";
+    case VERTEX_SNORM16:
+        return "2x int16 normalized";
+    default:
+        return "2x float32";
+    }
+}
+
+size_t vertexFormatBytes(VertexFormat format)
+{
+    return format == VERTEX_FLOAT32 ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+}
+
+VertexQuantization computeQuantization(const float *xy, size_t count)
+{
+    VertexQuantization q;
+    if (count == 0)
+        return q;
+
+    for (int axis = 0; axis < 2; axis++)
+    {
+        float lo = xy[axis], hi = xy[axis];
+        for (size_t i = 1; i < count; i++)
+        {
+            lo = std::min(lo, xy[2 * i + axis]);
+            hi = std::max(hi, xy[2 * i + axis]);
+        }
+        // A quarter of the extent as margin on each side, and never a zero-sized box
+        float half = std::max(0.5f * (hi - lo) * 1.5f, 1e-3f);
+        q.offset[axis] = 0.5f * (lo + hi);
+        q.scale[axis] = half;
+    }
+    return q;
+}
+
+bool quantizationContains(const VertexQuantization &q, const float *xy, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int axis = 0; axis < 2; axis++)
+        {
+            if (!(std::fabs(xy[2 * i + axis] - q.offset[axis]) <= q.scale[axis]))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Round to nearest even with integer tricks on the float bits (after F. Giesen)
+uint16_t floatToHalf(float value)
+{
+    uint32_t f;
+    memcpy(&f, &value, sizeof(f));
+    uint32_t sign = (f >> 16) & 0x8000;
+    f &= 0x7fffffff;
+
+    if (f >= 0x47800000) // 65536 or more, infinity or NaN
+        return sign | (f > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+    if (f < 0x38800000) // Below the smallest normal half: let the FPU round into the subnormal range
+    {
+        const uint32_t magicBits = 126u << 23; // 0.5f, whose ulp is the smallest half subnormal
+        float magic, sum;
+        memcpy(&magic, &magicBits, sizeof(magic));
+        memcpy(&sum, &f, sizeof(sum));
+        sum += magic;
+        uint32_t bits;
+        memcpy(&bits, &sum, sizeof(bits));
+        return sign | (uint16_t)(bits - magicBits);
+    }
+
+    uint32_t mantissaOdd = (f >> 13) & 1;
+    f += 0xc8000fffu + mantissaOdd; // Rebias the exponent (15 - 127) and round the dropped 13 bits
+    return sign | (uint16_t)(f >> 13);
+}
+
+float halfToFloat(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f, mantissa = half & 0x3ff;
+    if (exponent == 0)
+    {
+        float value = std::ldexp((float)mantissa, -24);
+        return sign ? -value : value;
+    }
+
+    uint32_t bits = sign | (exponent == 31 ? 0x7f800000 | (mantissa << 13) : ((exponent + 112) << 23) | (mantissa << 13));
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define VERTEXFORMAT_X86 1
+#include <immintrin.h>
+
+// Eight floats at a time with the F16C conversion instruction, same rounding as floatToHalf
+__attribute__((target("avx,f16c"))) static size_t packHalfF16C(const float *in, size_t n, uint16_t *out)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128((__m128i *)(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    return i;
+}
+
+static bool haveF16C()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+}
+#endif
+
+static void packHalf(const float *in, size_t n, uint16_t *out)
+{
+    size_t i = 0;
+#if VERTEXFORMAT_X86
+    static const bool f16c = haveF16C();
+    if (f16c)
+        i = packHalfF16C(in, n, out);
+#endif
+    for (; i < n; i++)
+        out[i] = floatToHalf(in[i]);
+}
+
+static inline int16_t packSnorm(float v, float offset, float inverse)
+{
+    v = std::min(std::max((v - offset) * inverse, -1.0f), 1.0f) * 32767.0f;
+    return (int16_t)std::nearbyint(v);
+}
+
+static void packSnorm16(const VertexQuantization &q, const float *xy, size_t count, uint16_t *out)
+{
+    float inverse[2] = {1.0f / q.scale[0], 1.0f / q.scale[1]};
+    size_t i = 0;
+#if VERTEXFORMAT_X86
+    // Four vertices per step: (x, y) lanes alternate, so do the offsets and scales
+    const __m128 offset = _mm_setr_ps(q.offset[0], q.offset[1], q.offset[0], q.offset[1]);
+    const __m128 scale = _mm_setr_ps(inverse[0], inverse[1], inverse[0], inverse[1]);
+    const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), unit = _mm_set1_ps(32767.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xy + 2 * i), offset), scale);
+        __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xy + 2 * i + 4), offset), scale);
+        a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(a, minusOne), one), unit);
+        b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(b, minusOne), one), unit);
+        // cvtps rounds to nearest even like nearbyint; the values already fit in int16
+        _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[2 * i] = (uint16_t)packSnorm(xy[2 * i], q.offset[0], inverse[0]);
+        out[2 * i + 1] = (uint16_t)packSnorm(xy[2 * i + 1], q.offset[1], inverse[1]);
+    }
+}
+
+void packVertices(VertexFormat format, const VertexQuantization &q, const float *xy, size_t count, void *dst)
+{
+    uint16_t *out = static_cast<uint16_t *>(dst);
+    if (format == VERTEX_FLOAT32)
+        memcpy(dst, xy, 2 * count * sizeof(float));
+    else if (format == VERTEX_FLOAT16)
+        packHalf(xy, 2 * count, out);
+    else
+        packSnorm16(q, xy, count, out);
+}
+
+void unpackVertices(VertexFormat format, const VertexQuantization &q, const void *src, size_t count, float *xy)
+{
+    if (format == VERTEX_FLOAT32)
+    {
+        memcpy(xy, src, 2 * count * sizeof(float));
+        return;
+    }
+
+    const uint16_t *in = static_cast<const uint16_t *>(src);
+    for (size_t i = 0; i < 2 * count; i++)
+    {
+        int axis = i & 1;
+        if (format == VERTEX_FLOAT16)
+            xy[i] = halfToFloat(in[i]);
+        else // GL's signed normalized conversion, then the shader's dequantize
+            xy[i] = std::max((int16_t)in[i] / 32767.0f, -1.0f) * q.scale[axis] + q.offset[axis];
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Storage formats for (x, y) vertices in a vertex buffer
+enum VertexFormat
+{
+    VERTEX_FLOAT32, // 8 bytes, exact
+    VERTEX_FLOAT16, // 4 bytes, 11 significant bits
+    VERTEX_SNORM16, // 4 bytes, 16 bits over the curve's bounding box
+    VERTEX_FORMAT_COUNT
+};
+
+const char *vertexFormatName(VertexFormat format);
+size_t vertexFormatBytes(VertexFormat format); // Per vertex
+
+// Stored vertex v maps back to position v * scale + offset, per axis. This is
+// what the dequantize uniform of vshader.vs applies; identity unless snorm16.
+struct VertexQuantization
+{
+    float scale[2] = {1.0f, 1.0f};
+    float offset[2] = {0.0f, 0.0f};
+};
+
+// Bounding box of count (x, y) pairs, grown by a margin so that dragging a point
+// a little does not immediately force the whole curve to be re-quantized
+VertexQuantization computeQuantization(const float *xy, size_t count);
+// True if every one of the count (x, y) pairs is representable under q
+bool quantizationContains(const VertexQuantization &q, const float *xy, size_t count);
+
+uint16_t floatToHalf(float value); // Round to nearest even, IEEE 754 binary16
+float halfToFloat(uint16_t half);
+
+// Convert count (x, y) pairs to format. dst holds vertexFormatBytes(format) * count bytes.
+void packVertices(VertexFormat format, const VertexQuantization &q, const float *xy, size_t count, void *dst);
+// The positions the vertex shader will see for count packed vertices
+void unpackVertices(VertexFormat format, const VertexQuantization &q, const void *src, size_t count, float *xy);
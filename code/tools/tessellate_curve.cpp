@@ -0,0 +1,247 @@
+// Headless batch tessellation: reads curves of interpolated control points,
+// builds the same piecewise cubic Bezier curves as the editor and streams out
+// the tessellated vertices. No window or GL context is involved.
+//
+// Usage: tessellate_curve [options] [input files...]   (no file or "-" reads stdin)
+//   -i, --input text|binary    input format (default text)
+//   -f, --format text|binary   output format (default text)
+//   -o, --output FILE          write to FILE instead of stdout
+//   -m, --mode direct|forward|adaptive
+//                              tessellation backend (default direct)
+//   -g, --tangents central|natural
+//                              central differences (C1, default) or the natural
+//                              spline (C2), solved across the threads on long curves
+//   -t, --tolerance PX         adaptive tolerance in pixels (default 1.25)
+//   -s, --scale PX             pixels per input unit, for the tolerance (default 320,
+//                              i.e. NDC coordinates in the editor's 640x640 window)
+//   -j, --threads N            worker threads for long curves (default: all cores)
+//
+// Text: one "x y" pair per line, '#' starts a comment, a blank line ends a curve.
+// Binary: per curve a uint32 point count followed by that many float32 (x, y) pairs,
+// in native byte order. Output uses the same format with tessellated vertices.
+// Exits with status 1 if an input cannot be read to its end or holds a line that
+// cannot be parsed (which is skipped).
+
+#include "curve.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static bool textInput = true, textOutput = true;
+static bool skippedLines = false; // Some text line could not be parsed
+
+enum CurveRead
+{
+    CURVE_END,  // Clean end of input
+    CURVE_READ, // A curve is in curveDocument
+    CURVE_ERROR // Input ended inside a curve or is corrupt
+};
+
+// Read the next curve into curveDocument (whose document space is NDC here)
+static CurveRead readCurve(FILE *in)
+{
+    curveDocumentClear(curveDocument);
+    if (!textInput)
+    {
+        unsigned int n;
+        if (fread(&n, sizeof(n), 1, in) != 1)
+            return feof(in) ? CURVE_END : CURVE_ERROR;
+        if (n > INT_MAX / 2)
+        {
+            fprintf(stderr, "tessellate_curve: corrupt binary curve of %u points\n", n);
+            return CURVE_ERROR;
+        }
+        // A seekable input must still hold the points; otherwise read them in chunks,
+        // so that a corrupt count allocates no more than the input actually holds
+        long here = ftell(in);
+        if (here >= 0 && fseek(in, 0, SEEK_END) == 0)
+        {
+            long size = ftell(in);
+            fseek(in, here, SEEK_SET);
+            if (size - here < (long)(2 * sizeof(float)) * n)
+            {
+                fprintf(stderr, "tessellate_curve: truncated binary curve\n");
+                return CURVE_ERROR;
+            }
+        }
+        std::vector<float> xy;
+        const size_t chunk = 1 << 16;
+        while (xy.size() < 2 * (size_t)n)
+        {
+            size_t have = xy.size(), want = std::min(2 * (size_t)n - have, chunk);
+            xy.resize(have + want);
+            if (fread(&xy[have], sizeof(float), want, in) != want)
+            {
+                fprintf(stderr, "tessellate_curve: truncated binary curve\n");
+                return CURVE_ERROR;
+            }
+        }
+        curveDocument.x.resize(n);
+        curveDocument.y.resize(n);
+        for (size_t i = 0; i < n; i++)
+            curveDocumentMove(curveDocument, i, xy[2 * i], xy[2 * i + 1]);
+        return CURVE_READ;
+    }
+
+    char line[256];
+    bool any = false;
+    while (fgets(line, sizeof(line), in))
+    {
+        char *p = line;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '#')
+            continue;
+        if (*p == '\n' || *p == '\r' || *p == '\0')
+        {
+            if (any)
+                return CURVE_READ;
+            continue;
+        }
+
+        char *xEnd, *end;
+        float x = strtof(p, &xEnd);
+        float y = strtof(xEnd, &end);
+        bool parsed = xEnd != p && end != xEnd;
+        while (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n')
+            end++;
+        if (!parsed || (*end != '\0' && *end != '#'))
+        {
+            fprintf(stderr, "tessellate_curve: cannot parse line: %s", line);
+            skippedLines = true;
+            continue;
+        }
+        curveDocumentAdd(curveDocument, x, y);
+        any = true;
+    }
+    if (ferror(in))
+        return CURVE_ERROR;
+    return any ? CURVE_READ : CURVE_END;
+}
+
+static void writeCurve(FILE *out)
+{
+    size_t n = piecewiseBezier.size() / 2;
+    if (!textOutput)
+    {
+        unsigned int count = n;
+        fwrite(&count, sizeof(count), 1, out);
+        fwrite(piecewiseBezier.data(), sizeof(float), piecewiseBezier.size(), out);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        fprintf(out, "%.9g %.9g\n", piecewiseBezier[2 * i], piecewiseBezier[2 * i + 1]);
+    fputc('\n', out);
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: tessellate_curve [-i text|binary] [-f text|binary] [-o file]\n"
+                    "                        [-m direct|forward|adaptive] [-g central|natural] [-t px] [-s px]\n"
+                    "                        [-j threads] [files...]\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outputName = nullptr;
+    std::vector<const char *> inputs;
+    showTangents = false;
+
+    for (int a = 1; a < argc; a++)
+    {
+        const char *arg = argv[a];
+        auto value = [&]()
+        {
+            if (a + 1 >= argc)
+                usage();
+            return argv[++a];
+        };
+
+        if (!strcmp(arg, "-i") || !strcmp(arg, "--input"))
+            textInput = strcmp(value(), "binary") != 0;
+        else if (!strcmp(arg, "-f") || !strcmp(arg, "--format"))
+            textOutput = strcmp(value(), "binary") != 0;
+        else if (!strcmp(arg, "-o") || !strcmp(arg, "--output"))
+            outputName = value();
+        else if (!strcmp(arg, "-m") || !strcmp(arg, "--mode"))
+        {
+            const char *mode = value();
+            if (!strcmp(mode, "direct"))
+                tessellationMode = TESSELLATE_DIRECT;
+            else if (!strcmp(mode, "forward"))
+                tessellationMode = TESSELLATE_FORWARD_DIFFERENCE;
+            else if (!strcmp(mode, "adaptive"))
+                tessellationMode = TESSELLATE_ADAPTIVE;
+            else
+                usage();
+        }
+        else if (!strcmp(arg, "-g") || !strcmp(arg, "--tangents"))
+        {
+            const char *mode = value();
+            if (!strcmp(mode, "central"))
+                tangentMode = TANGENTS_CENTRAL_DIFFERENCE;
+            else if (!strcmp(mode, "natural"))
+                tangentMode = TANGENTS_NATURAL_SPLINE;
+            else
+                usage();
+        }
+        else if (!strcmp(arg, "-t") || !strcmp(arg, "--tolerance"))
+            curveTolerance = atof(value());
+        else if (!strcmp(arg, "-s") || !strcmp(arg, "--scale"))
+            ndcToPixelsX = ndcToPixelsY = atof(value());
+        else if (!strcmp(arg, "-j") || !strcmp(arg, "--threads"))
+            setThreadPoolSize(atoi(value()));
+        else if (!strcmp(arg, "-h") || !strcmp(arg, "--help") || (arg[0] == '-' && arg[1] != '\0'))
+            usage();
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty())
+        inputs.push_back("-");
+
+    FILE *out = outputName ? fopen(outputName, textOutput ? "w" : "wb") : stdout;
+    if (out == NULL)
+    {
+        perror(outputName);
+        return 1;
+    }
+    static char outBuffer[1 << 20];
+    setvbuf(out, outBuffer, _IOFBF, sizeof(outBuffer));
+
+    int status = 0;
+    for (const char *name : inputs)
+    {
+        bool isStdin = !strcmp(name, "-");
+        FILE *in = isStdin ? stdin : fopen(name, textInput ? "r" : "rb");
+        if (in == NULL)
+        {
+            perror(name);
+            status = 1;
+            continue;
+        }
+
+        CurveRead read;
+        while ((read = readCurve(in)) == CURVE_READ)
+        {
+            calculatePiecewiseBezier();
+            writeCurve(out);
+        }
+        if (read == CURVE_ERROR)
+        {
+            fprintf(stderr, "tessellate_curve: error reading %s\n", isStdin ? "stdin" : name);
+            status = 1;
+        }
+        if (!isStdin)
+            fclose(in);
+    }
+
+    if (fclose(out) != 0 || skippedLines)
+        status = 1;
+    return status;
+}